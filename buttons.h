@@ -13,22 +13,15 @@
 
 #include <stdint.h>
 
-#define NO_BUTTON_PUSHED (-1)
-
 /* Set up pin change interrupts on pins B0 to B3.
  * It is assumed that global interrupts are off when this function is called
  * and are enabled sometime after this function is called.
  */
 void init_button_interrupts(void);
 
-/* Return the last button pushed (0 to 3) or -1 (NO_BUTTON_PUSHED) if 
- * there are no button pushes to return. (A small queue of button pushes
- * is kept. This function should be called frequently enough to
- * ensure the queue does not overflow. Excess button pushes are
- * discarded.)
+/* Button pushes are reported as INPUT_BUTTON events (see input_events.h)
+ * with the button number (0 to 3) as the value. Releases are ignored.
  */
 
-int8_t button_pushed(void);
-
 
 #endif /* BUTTONS_H_ */
\ No newline at end of file
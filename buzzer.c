@@ -3,6 +3,13 @@
  *
  * Created: 2019-10-08 오후 9:47:33
  *  Author: Youngsu Choi
+ *
+ * Timer 1 toggles the buzzer pin (OC1A) on compare match, so the tone is
+ * made by the hardware and needs no interrupt handler. Each sound is a
+ * list of notes in program memory - the compare value (which sets the 
+ * pitch) and how long (ms) it is played for. buzzer_tick(), called from
+ * the timer 0 interrupt handler every millisecond, counts down the note 
+ * playing and moves on to the next note (or the next sound) when it ends.
  */ 
 
 #include "buzzer.h"
@@ -11,17 +18,56 @@
 #include <stdlib.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
 #include <stdio.h>
 #include "timer0.h"
 
 uint8_t game_paused = 0;
-volatile uint16_t count = 0;
-volatile uint32_t current_sound_time;
-volatile uint32_t sound_time_end;
-volatile uint8_t partial_death;
-volatile uint8_t power_pellet;
-volatile uint8_t ghost_eat;
-volatile uint8_t mute;
+
+// Timer 1 clock select bits for each clock divider we use
+#define CLOCK_DIV_8 (1 << CS11)
+#define CLOCK_DIV_64 ((1 << CS11) | (1 << CS10))
+#define CLOCK_BITS ((1 << CS12) | (1 << CS11) | (1 << CS10))
+
+typedef struct {
+	uint16_t top;		// OCR1A value - the tone is clock / (2 * (top + 1))
+	uint16_t duration;	// ms - 0 marks the end of the sound
+} Note;
+
+typedef struct {
+	const Note* notes;
+	uint8_t clock;		// Timer 1 clock select bits
+	uint8_t priority;	// Higher priority sounds are played first
+} Sound;
+
+static const Note power_pellet_notes[] PROGMEM = {
+	{399, 700}, {349, 300}, {299, 300}, {0, 0}
+};
+static const Note new_game_notes[] PROGMEM = {
+	{399, 1200}, {449, 500}, {499, 500}, {0, 0}
+};
+static const Note ghost_eaten_notes[] PROGMEM = {
+	{399, 1700}, {0, 0}
+};
+
+static const Sound sounds[NUM_SOUNDS] PROGMEM = {
+	{power_pellet_notes, CLOCK_DIV_64, 0},	// SOUND_POWER_PELLET
+	{new_game_notes, CLOCK_DIV_8, 2},		// SOUND_NEW_GAME
+	{ghost_eaten_notes, CLOCK_DIV_64, 1}	// SOUND_GHOST_EATEN
+};
+
+#define NO_SOUND 0xFF
+
+// The sound playing (NO_SOUND if none), its next note and the time (ms)
+// left of the note playing. These are only changed with interrupts off 
+// (or from the timer 0 interrupt handler).
+static uint8_t playing_sound = NO_SOUND;
+static const Note* next_note;
+static uint16_t note_time_left;
+
+// Sounds waiting to be played - highest priority first
+static uint8_t waiting_sounds[SOUND_QUEUE_SIZE];
+static uint8_t num_waiting_sounds;
 
 void toggle_game_paused(uint8_t value) {
 	game_paused = value;
@@ -30,89 +76,120 @@ void toggle_game_paused(uint8_t value) {
 void init_buzzer(void) {
 	DDRD |= (1 << 5);
 	
+	// CTC mode, toggling OC1A on compare match. The timer is stopped (no 
+	// clock selected) until a sound is played.
 	TCCR1A = (0 << COM1A1) | (1 << COM1A0) | (0 << WGM11) | (0 << WGM10); 
 	TCCR1B = (0 << WGM13) | (1 << WGM12); 
 	
-	/* Enable interrupt timer on output compare match 
-	*/
-	TIMSK1 = (1 << OCIE1A);
-
-	/* Ensure interrupt flag is cleared */
-	TIFR1 = (1 << OCF1A);
+	// No interrupts - the hardware makes the tone
+	TIMSK1 = 0;
 	
-	sei();
+	playing_sound = NO_SOUND;
+	note_time_left = 0;
+	num_waiting_sounds = 0;
 }
 
-void set_prescalar(uint8_t sound_code) {
-	if ((PIND & (1 << 7)) == 0) {
-		if (sound_code == 1) {
-			OCR1A = 399;
-			power_pellet = 1;
-			TCCR1B |= (1 << CS11) | (1 << CS10);
-		}
-		
-		if (sound_code == 2) {
-			OCR1A = 399;
-			partial_death = 1;
-			TCCR1B |= (1 << CS11);
-		}
-		
-		if (sound_code == 3) {
-			OCR1A = 399;
-			ghost_eat = 1;
-			TCCR1B |= (1 << CS11) | (1 << CS10);
+static uint8_t sound_priority(uint8_t sound) {
+	return pgm_read_byte(&sounds[sound].priority);
+}
+
+// Stop the timer (and so the tone)
+static void stop_tone(void) {
+	TCCR1B &= ~CLOCK_BITS;
+	DDRD &= ~(1 << 5);
+	DDRD |= (1 << 5);
+}
+
+static void start_sound(uint8_t sound);
+
+// Play the next note of the sound playing. At the end of the sound start
+// the next sound waiting (or stop if there isn't one). Interrupts must be 
+// off.
+static void start_next_note(void) {
+	uint16_t duration = pgm_read_word(&next_note->duration);
+	if (duration == 0) {
+		playing_sound = NO_SOUND;
+		if (num_waiting_sounds > 0) {
+			uint8_t sound = waiting_sounds[0];
+			num_waiting_sounds--;
+			for (uint8_t i = 0; i < num_waiting_sounds; i++) {
+				waiting_sounds[i] = waiting_sounds[i + 1];
+			}
+			start_sound(sound);
+		} else {
+			stop_tone();
 		}
-		
-		sound_time_end = get_sound_time() + 200;
+		return;
 	}
+	// Restart the count so that it can't be past the new compare value 
+	// (it would then count all the way to 0xFFFF before toggling)
+	OCR1A = pgm_read_word(&next_note->top);
+	TCNT1 = 0;
+	note_time_left = duration;
+	next_note++;
 }
 
-ISR(TIMER1_COMPA_vect) {
-	
-	current_sound_time = get_current_time();
+// Set up the timer for a sound and play its first note. Interrupts must
+// be off.
+static void start_sound(uint8_t sound) {
+	playing_sound = sound;
+	next_note = (const Note*)pgm_read_word(&sounds[sound].notes);
+	TCCR1B = (TCCR1B & ~CLOCK_BITS) | pgm_read_byte(&sounds[sound].clock);
+	start_next_note();
+}
+
+// Add a sound to the queue of sounds waiting, after those of the same or
+// higher priority. Interrupts must be off.
+static void queue_sound(uint8_t sound) {
+	uint8_t priority = sound_priority(sound);
+	uint8_t position;
 	
-	if (ghost_eat == 1) {
-		if (current_sound_time >= sound_time_end + 1500) {
-			TCCR1B &= ~((1 << CS12) | (1 << CS11) | (1 << CS10));
-			ghost_eat = 0;
-			DDRD &= ~(1 << 5);
-			DDRD |= (1 << 5);
+	for (position = 0; position < num_waiting_sounds; position++) {
+		if (waiting_sounds[position] == sound) {
+			// Already waiting
+			return;
 		}
 	}
-
-	if (partial_death == 1) {
-		if (current_sound_time >= sound_time_end + 1000) {
-			OCR1A = 449;
-		}
-		if (current_sound_time >= sound_time_end + 1500) {
-			OCR1A = 499;
+	for (position = 0; position < num_waiting_sounds; position++) {
+		if (sound_priority(waiting_sounds[position]) < priority) {
+			break;
 		}
-		if (current_sound_time >= sound_time_end + 2000) {
-			TCCR1B &= ~((1 << CS12));
-			TCCR1B &= ~((1 << CS10));
-			TCCR1B &= ~((1 << CS11));
-			partial_death = 0;
-			DDRD &= ~(1 << 5);
-			DDRD |= (1 << 5);
-		}	
+	}
+	if (position >= SOUND_QUEUE_SIZE) {
+		// Queue is full of sounds at least as important - drop this one
+		return;
+	}
+	if (num_waiting_sounds < SOUND_QUEUE_SIZE) {
+		num_waiting_sounds++;
+	}
+	// Move the lower priority sounds back (dropping the last if the queue
+	// was full)
+	for (uint8_t i = num_waiting_sounds - 1; i > position; i--) {
+		waiting_sounds[i] = waiting_sounds[i - 1];
+	}
+	waiting_sounds[position] = sound;
+}
+
+void play_sound(uint8_t sound) {
+	if ((PIND & (1 << 7)) != 0) {
+		// Muted
+		return;
 	}
 	
-	if (power_pellet == 1) {
-		if (current_sound_time >= sound_time_end + 500) {
-			OCR1A = 349;
-		}
-		
-		if (current_sound_time >= sound_time_end + 800) {
-			OCR1A = 299;
-		}
-		
-		if (current_sound_time >= sound_time_end + 1100) {
-			TCCR1B &= ~((1 << CS12));
-			TCCR1B &= ~((1 << CS10));
-			TCCR1B &= ~((1 << CS11));
-			DDRD &= ~(1 << 5);
-			DDRD |= (1 << 5);
-			power_pellet = 0;
-		}
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	if (playing_sound == NO_SOUND) {
+		start_sound(sound);
+	} else {
+		queue_sound(sound);
+	}
+	if (interrupts_were_enabled) {
+		sei();
+	}
+}
+
+void buzzer_tick(void) {
+	if (note_time_left != 0 && --note_time_left == 0) {
+		start_next_note();
 	}
 }
\ No newline at end of file
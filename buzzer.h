@@ -9,9 +9,28 @@
 #ifndef BUZZER_H_
 #define BUZZER_H_
 
+#include <stdint.h>
+
+// Sounds that can be passed to play_sound() below
+#define SOUND_POWER_PELLET 0
+#define SOUND_NEW_GAME 1
+#define SOUND_GHOST_EATEN 2
+#define NUM_SOUNDS 3
+
+// Number of sounds that can be waiting to be played after the one playing
+#define SOUND_QUEUE_SIZE 4
+
 void init_buzzer(void);
 void toggle_game_paused(uint8_t value);
-void set_prescalar(uint8_t sound_code);
 
+// Play a sound (unless the mute switch is on). If a sound is already 
+// playing the new one waits until it has finished - sounds that are waiting
+// are played highest priority first. A sound that is already waiting isn't
+// added again. If the queue is full the lowest priority sound is dropped.
+void play_sound(uint8_t sound);
+
+// Called every millisecond by the timer 0 interrupt handler - moves on to
+// the next note when the one playing has finished
+void buzzer_tick(void);
 
 #endif /* BUZZER_H_ */
\ No newline at end of file
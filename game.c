@@ -6,6 +6,8 @@
 */
 
 #include "game.h"
+#include "maze.h"
+#include "maze_graph.h"
 #include <stdio.h>
 #include "ledmatrix.h"
 #include "terminalio.h"
@@ -17,65 +19,53 @@
 #include "score.h"
 #include "buzzer.h"
 #include "lives.h"
+#include "serialio.h"
 #include <avr/eeprom.h>
 /* Stdlib needed for random() - random number generator */
 
 ///////////////////////////////////////////////////////////
 // Initial game field
-// The string below has 31 elements for each of the 31 rows. The index into 
-// the string is row_number * 31 + column_number.
-// Each location is one of the following values:
-// (space) - nothing at this location
-// - - horizontal wall at this location - uses LINE_HORIZONTAL
-// | - vertical wall at this location - uses LINE_VERTICAL
-// F - wall is down and to the right - uses LINE_DOWN_AND_RIGHT
-// 7 - wall is down and to the left - uses LINE_DOWN_AND_LEFT
-// L - wall is up and to the right - uses LINE_UP_AND_RIGHT
-// J - wall is up and to the left - uses LINE_UP_AND_LEFT
-// > - wall is vertical and to the right - uses LINE_VERTICAL_AND_RIGHT
-// < - wall is vertical and to the left - uses LINE_VERTICAL_AND_LEFT
-// ^ - wall is horizontal and up - uses LINE_HORIZONTAL_AND_UP
-// v - wall is horizontal and down - uses LINE_HORIZONTAL_AND_DOWN
-// + - wall is in all directions - uses LINE_VERTICAL_AND_HORIZONTAL
-// . - pacdot initially at this location
-// P - power pellet initial location (initially implemented just as a pac-dot)
+// The string below has 31 elements for each of the 31 rows (MAZE_ROW_0 to
+// MAZE_ROW_30 - see maze.h). The index into the string is 
+// row_number * 31 + column_number.
 //
 // This array is stored in program memory to preserve RAM. (1 is added to 
 // size to allow for null character at end of string.)
 // (Note that string constants with whitespace between them are concatenated.)
+// The tables below are also worked out from the row strings by the compiler.
 
 static const char init_game_field[FIELD_HEIGHT*FIELD_WIDTH + 1] PROGMEM =
-	"F-------------v-v-------------7"
-	"|.............| |.............|"
-	"|.F---7.F---7.| |.F---7.F---7.|"
-	"|.|   |.L---J.L-J.L---J.|   |.|"
-	"|.|   |.................|   |.|"
-	"|.|   |.F---7.F-7.F---7.|   |.|"
-	"|PL---J.L---J.L-J.L---J.L---JP|"
-	"|.............................|"
-	"|.F---7.F7.F-------7.F7.F---7.|"
-	"|.L---J.||.L--7 F--J.||.L---J.|"
-	"|.......||....| |....||.......|"
-	"L-----7.|L--7 | | F--J|.F-----J"
-	"      |.|F--J L-J L--7|.|      "
-	"      |.||           ||.|      "
-	"------J.LJ F--   --7 LJ.L------"
-	"       .   |       |   .       "
-	"------7.F7 L-------J F7.F------"
-	"      |.||           ||.|      "
-	"      |.|| F-------7 ||.|      "
-	"F-----J.LJ L--7 F--J LJ.L-----7"
-	"|.............| |.............|"
-	"|.F---7.F---7.| |.F---7.F---7.|"
-	"|.L-7 |.L---J.L-J.L---J.| F-J.|"
-	"|P..| |........ ........| |..P|"
-	">-7.| |.F7.F-------7.F7.| |.F-<"
-	">-J.L-J.||.L--7 F--J.||.L-J.L-<"
-	"|.......||....| |....||.......|"
-	"|.F-----JL--7.| |.F--JL-----7.|"
-	"|.L---------J.L-J.L---------J.|"
-	"|.............................|"
-	"L-----------------------------J";
+	MAZE_ROW_0
+	MAZE_ROW_1
+	MAZE_ROW_2
+	MAZE_ROW_3
+	MAZE_ROW_4
+	MAZE_ROW_5
+	MAZE_ROW_6
+	MAZE_ROW_7
+	MAZE_ROW_8
+	MAZE_ROW_9
+	MAZE_ROW_10
+	MAZE_ROW_11
+	MAZE_ROW_12
+	MAZE_ROW_13
+	MAZE_ROW_14
+	MAZE_ROW_15
+	MAZE_ROW_16
+	MAZE_ROW_17
+	MAZE_ROW_18
+	MAZE_ROW_19
+	MAZE_ROW_20
+	MAZE_ROW_21
+	MAZE_ROW_22
+	MAZE_ROW_23
+	MAZE_ROW_24
+	MAZE_ROW_25
+	MAZE_ROW_26
+	MAZE_ROW_27
+	MAZE_ROW_28
+	MAZE_ROW_29
+	MAZE_ROW_30;
 
 // Array to store the game dots (pacdots) - each element in the array is a 32 bit integer, 
 // representing the absence/presence of pacdots in each row. The first element in 
@@ -92,19 +82,187 @@ static uint32_t pacdots[FIELD_HEIGHT];
 // We also keep a count of the number of pac-dots remaining on the game field
 static uint16_t num_pacdots;
 
+// The pac-dots each level starts with - the initial value of pacdots[]. 
+// This is worked out by the compiler from the MAZE_ROW strings above (a 
+// character in a string constant at a constant index is a constant) so it 
+// can't get out of step with init_game_field, and a level is started by
+// copying it rather than by examining all 961 characters of the field.
+#define IS_INITIAL_PACDOT(row, x) ((row)[x] == '.' || (row)[x] == 'P')
+#define INITIAL_PACDOT_BIT(row, x) (IS_INITIAL_PACDOT(row, x) ? (1UL << (x)) : 0)
+#define INITIAL_PACDOT_ROW(row) ( \
+		INITIAL_PACDOT_BIT(row, 0) | INITIAL_PACDOT_BIT(row, 1) | INITIAL_PACDOT_BIT(row, 2) | \
+		INITIAL_PACDOT_BIT(row, 3) | INITIAL_PACDOT_BIT(row, 4) | INITIAL_PACDOT_BIT(row, 5) | \
+		INITIAL_PACDOT_BIT(row, 6) | INITIAL_PACDOT_BIT(row, 7) | INITIAL_PACDOT_BIT(row, 8) | \
+		INITIAL_PACDOT_BIT(row, 9) | INITIAL_PACDOT_BIT(row, 10) | INITIAL_PACDOT_BIT(row, 11) | \
+		INITIAL_PACDOT_BIT(row, 12) | INITIAL_PACDOT_BIT(row, 13) | INITIAL_PACDOT_BIT(row, 14) | \
+		INITIAL_PACDOT_BIT(row, 15) | INITIAL_PACDOT_BIT(row, 16) | INITIAL_PACDOT_BIT(row, 17) | \
+		INITIAL_PACDOT_BIT(row, 18) | INITIAL_PACDOT_BIT(row, 19) | INITIAL_PACDOT_BIT(row, 20) | \
+		INITIAL_PACDOT_BIT(row, 21) | INITIAL_PACDOT_BIT(row, 22) | INITIAL_PACDOT_BIT(row, 23) | \
+		INITIAL_PACDOT_BIT(row, 24) | INITIAL_PACDOT_BIT(row, 25) | INITIAL_PACDOT_BIT(row, 26) | \
+		INITIAL_PACDOT_BIT(row, 27) | INITIAL_PACDOT_BIT(row, 28) | INITIAL_PACDOT_BIT(row, 29) | \
+		INITIAL_PACDOT_BIT(row, 30))
+#define INITIAL_PACDOT_COUNT(row) ( \
+		IS_INITIAL_PACDOT(row, 0) + IS_INITIAL_PACDOT(row, 1) + IS_INITIAL_PACDOT(row, 2) + \
+		IS_INITIAL_PACDOT(row, 3) + IS_INITIAL_PACDOT(row, 4) + IS_INITIAL_PACDOT(row, 5) + \
+		IS_INITIAL_PACDOT(row, 6) + IS_INITIAL_PACDOT(row, 7) + IS_INITIAL_PACDOT(row, 8) + \
+		IS_INITIAL_PACDOT(row, 9) + IS_INITIAL_PACDOT(row, 10) + IS_INITIAL_PACDOT(row, 11) + \
+		IS_INITIAL_PACDOT(row, 12) + IS_INITIAL_PACDOT(row, 13) + IS_INITIAL_PACDOT(row, 14) + \
+		IS_INITIAL_PACDOT(row, 15) + IS_INITIAL_PACDOT(row, 16) + IS_INITIAL_PACDOT(row, 17) + \
+		IS_INITIAL_PACDOT(row, 18) + IS_INITIAL_PACDOT(row, 19) + IS_INITIAL_PACDOT(row, 20) + \
+		IS_INITIAL_PACDOT(row, 21) + IS_INITIAL_PACDOT(row, 22) + IS_INITIAL_PACDOT(row, 23) + \
+		IS_INITIAL_PACDOT(row, 24) + IS_INITIAL_PACDOT(row, 25) + IS_INITIAL_PACDOT(row, 26) + \
+		IS_INITIAL_PACDOT(row, 27) + IS_INITIAL_PACDOT(row, 28) + IS_INITIAL_PACDOT(row, 29) + \
+		IS_INITIAL_PACDOT(row, 30))
+
+static const uint32_t initial_pacdots[FIELD_HEIGHT] PROGMEM = {
+	INITIAL_PACDOT_ROW(MAZE_ROW_0), INITIAL_PACDOT_ROW(MAZE_ROW_1),
+	INITIAL_PACDOT_ROW(MAZE_ROW_2), INITIAL_PACDOT_ROW(MAZE_ROW_3),
+	INITIAL_PACDOT_ROW(MAZE_ROW_4), INITIAL_PACDOT_ROW(MAZE_ROW_5),
+	INITIAL_PACDOT_ROW(MAZE_ROW_6), INITIAL_PACDOT_ROW(MAZE_ROW_7),
+	INITIAL_PACDOT_ROW(MAZE_ROW_8), INITIAL_PACDOT_ROW(MAZE_ROW_9),
+	INITIAL_PACDOT_ROW(MAZE_ROW_10), INITIAL_PACDOT_ROW(MAZE_ROW_11),
+	INITIAL_PACDOT_ROW(MAZE_ROW_12), INITIAL_PACDOT_ROW(MAZE_ROW_13),
+	INITIAL_PACDOT_ROW(MAZE_ROW_14), INITIAL_PACDOT_ROW(MAZE_ROW_15),
+	INITIAL_PACDOT_ROW(MAZE_ROW_16), INITIAL_PACDOT_ROW(MAZE_ROW_17),
+	INITIAL_PACDOT_ROW(MAZE_ROW_18), INITIAL_PACDOT_ROW(MAZE_ROW_19),
+	INITIAL_PACDOT_ROW(MAZE_ROW_20), INITIAL_PACDOT_ROW(MAZE_ROW_21),
+	INITIAL_PACDOT_ROW(MAZE_ROW_22), INITIAL_PACDOT_ROW(MAZE_ROW_23),
+	INITIAL_PACDOT_ROW(MAZE_ROW_24), INITIAL_PACDOT_ROW(MAZE_ROW_25),
+	INITIAL_PACDOT_ROW(MAZE_ROW_26), INITIAL_PACDOT_ROW(MAZE_ROW_27),
+	INITIAL_PACDOT_ROW(MAZE_ROW_28), INITIAL_PACDOT_ROW(MAZE_ROW_29),
+	INITIAL_PACDOT_ROW(MAZE_ROW_30)
+};
+
+static const uint16_t initial_num_pacdots PROGMEM = 
+	INITIAL_PACDOT_COUNT(MAZE_ROW_0) + INITIAL_PACDOT_COUNT(MAZE_ROW_1) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_2) + INITIAL_PACDOT_COUNT(MAZE_ROW_3) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_4) + INITIAL_PACDOT_COUNT(MAZE_ROW_5) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_6) + INITIAL_PACDOT_COUNT(MAZE_ROW_7) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_8) + INITIAL_PACDOT_COUNT(MAZE_ROW_9) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_10) + INITIAL_PACDOT_COUNT(MAZE_ROW_11) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_12) + INITIAL_PACDOT_COUNT(MAZE_ROW_13) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_14) + INITIAL_PACDOT_COUNT(MAZE_ROW_15) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_16) + INITIAL_PACDOT_COUNT(MAZE_ROW_17) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_18) + INITIAL_PACDOT_COUNT(MAZE_ROW_19) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_20) + INITIAL_PACDOT_COUNT(MAZE_ROW_21) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_22) + INITIAL_PACDOT_COUNT(MAZE_ROW_23) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_24) + INITIAL_PACDOT_COUNT(MAZE_ROW_25) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_26) + INITIAL_PACDOT_COUNT(MAZE_ROW_27) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_28) + INITIAL_PACDOT_COUNT(MAZE_ROW_29) +
+	INITIAL_PACDOT_COUNT(MAZE_ROW_30);
+
+// The tables above index each row string by column number so every row 
+// must be exactly FIELD_WIDTH characters long - stop the build if not.
+#define CHECK_MAZE_ROW(row) \
+		_Static_assert(sizeof(row) == FIELD_WIDTH + 1, "Maze row " #row " is the wrong length")
+CHECK_MAZE_ROW(MAZE_ROW_0); CHECK_MAZE_ROW(MAZE_ROW_1); CHECK_MAZE_ROW(MAZE_ROW_2);
+CHECK_MAZE_ROW(MAZE_ROW_3); CHECK_MAZE_ROW(MAZE_ROW_4); CHECK_MAZE_ROW(MAZE_ROW_5);
+CHECK_MAZE_ROW(MAZE_ROW_6); CHECK_MAZE_ROW(MAZE_ROW_7); CHECK_MAZE_ROW(MAZE_ROW_8);
+CHECK_MAZE_ROW(MAZE_ROW_9); CHECK_MAZE_ROW(MAZE_ROW_10); CHECK_MAZE_ROW(MAZE_ROW_11);
+CHECK_MAZE_ROW(MAZE_ROW_12); CHECK_MAZE_ROW(MAZE_ROW_13); CHECK_MAZE_ROW(MAZE_ROW_14);
+CHECK_MAZE_ROW(MAZE_ROW_15); CHECK_MAZE_ROW(MAZE_ROW_16); CHECK_MAZE_ROW(MAZE_ROW_17);
+CHECK_MAZE_ROW(MAZE_ROW_18); CHECK_MAZE_ROW(MAZE_ROW_19); CHECK_MAZE_ROW(MAZE_ROW_20);
+CHECK_MAZE_ROW(MAZE_ROW_21); CHECK_MAZE_ROW(MAZE_ROW_22); CHECK_MAZE_ROW(MAZE_ROW_23);
+CHECK_MAZE_ROW(MAZE_ROW_24); CHECK_MAZE_ROW(MAZE_ROW_25); CHECK_MAZE_ROW(MAZE_ROW_26);
+CHECK_MAZE_ROW(MAZE_ROW_27); CHECK_MAZE_ROW(MAZE_ROW_28); CHECK_MAZE_ROW(MAZE_ROW_29);
+CHECK_MAZE_ROW(MAZE_ROW_30);
+
+// Exits from each cell - bit n (1 << direction) of a cell's value is 1 if
+// the neighbouring cell in direction n (DIRN_LEFT etc.) isn't a wall. Cells
+// outside the field count as walls. Two cells are packed into each byte - 
+// the cell with the even column number in the low 4 bits - so a row 
+// takes 16 bytes (the last high 4 bits are unused). See cell_exits(). Like
+// initial_pacdots[] this is worked out by the compiler from the MAZE_ROW 
+// strings. (The index (x) - ((x) > 0) is used so that a string is never 
+// indexed outside its bounds. Index 31 is the null character at the end.)
+#define MAZE_ROW_OUTSIDE "-------------------------------"
+#define IS_OPEN(row, x) ((row)[x] == ' ' || (row)[x] == '.' || (row)[x] == 'P')
+#define CELL_EXITS(above, row, below, x) ( \
+		(((x) > 0 && IS_OPEN(row, (x) - ((x) > 0))) << DIRN_LEFT) | \
+		(IS_OPEN(above, x) << DIRN_UP) | \
+		(((x) < FIELD_WIDTH - 1 && IS_OPEN(row, (x) + ((x) < FIELD_WIDTH - 1))) << DIRN_RIGHT) | \
+		(IS_OPEN(below, x) << DIRN_DOWN))
+#define CELL_EXITS_PAIR(above, row, below, x) \
+		(CELL_EXITS(above, row, below, x) | (CELL_EXITS(above, row, below, (x) + 1) << 4))
+#define CELL_EXITS_ROW(above, row, below) { \
+		CELL_EXITS_PAIR(above, row, below, 0), \
+		CELL_EXITS_PAIR(above, row, below, 2), \
+		CELL_EXITS_PAIR(above, row, below, 4), \
+		CELL_EXITS_PAIR(above, row, below, 6), \
+		CELL_EXITS_PAIR(above, row, below, 8), \
+		CELL_EXITS_PAIR(above, row, below, 10), \
+		CELL_EXITS_PAIR(above, row, below, 12), \
+		CELL_EXITS_PAIR(above, row, below, 14), \
+		CELL_EXITS_PAIR(above, row, below, 16), \
+		CELL_EXITS_PAIR(above, row, below, 18), \
+		CELL_EXITS_PAIR(above, row, below, 20), \
+		CELL_EXITS_PAIR(above, row, below, 22), \
+		CELL_EXITS_PAIR(above, row, below, 24), \
+		CELL_EXITS_PAIR(above, row, below, 26), \
+		CELL_EXITS_PAIR(above, row, below, 28), \
+		CELL_EXITS_PAIR(above, row, below, 30) }
+
+static const uint8_t cell_exits_table[FIELD_HEIGHT][(FIELD_WIDTH + 1) / 2] PROGMEM = {
+	CELL_EXITS_ROW(MAZE_ROW_OUTSIDE, MAZE_ROW_0, MAZE_ROW_1),
+	CELL_EXITS_ROW(MAZE_ROW_0, MAZE_ROW_1, MAZE_ROW_2),
+	CELL_EXITS_ROW(MAZE_ROW_1, MAZE_ROW_2, MAZE_ROW_3),
+	CELL_EXITS_ROW(MAZE_ROW_2, MAZE_ROW_3, MAZE_ROW_4),
+	CELL_EXITS_ROW(MAZE_ROW_3, MAZE_ROW_4, MAZE_ROW_5),
+	CELL_EXITS_ROW(MAZE_ROW_4, MAZE_ROW_5, MAZE_ROW_6),
+	CELL_EXITS_ROW(MAZE_ROW_5, MAZE_ROW_6, MAZE_ROW_7),
+	CELL_EXITS_ROW(MAZE_ROW_6, MAZE_ROW_7, MAZE_ROW_8),
+	CELL_EXITS_ROW(MAZE_ROW_7, MAZE_ROW_8, MAZE_ROW_9),
+	CELL_EXITS_ROW(MAZE_ROW_8, MAZE_ROW_9, MAZE_ROW_10),
+	CELL_EXITS_ROW(MAZE_ROW_9, MAZE_ROW_10, MAZE_ROW_11),
+	CELL_EXITS_ROW(MAZE_ROW_10, MAZE_ROW_11, MAZE_ROW_12),
+	CELL_EXITS_ROW(MAZE_ROW_11, MAZE_ROW_12, MAZE_ROW_13),
+	CELL_EXITS_ROW(MAZE_ROW_12, MAZE_ROW_13, MAZE_ROW_14),
+	CELL_EXITS_ROW(MAZE_ROW_13, MAZE_ROW_14, MAZE_ROW_15),
+	CELL_EXITS_ROW(MAZE_ROW_14, MAZE_ROW_15, MAZE_ROW_16),
+	CELL_EXITS_ROW(MAZE_ROW_15, MAZE_ROW_16, MAZE_ROW_17),
+	CELL_EXITS_ROW(MAZE_ROW_16, MAZE_ROW_17, MAZE_ROW_18),
+	CELL_EXITS_ROW(MAZE_ROW_17, MAZE_ROW_18, MAZE_ROW_19),
+	CELL_EXITS_ROW(MAZE_ROW_18, MAZE_ROW_19, MAZE_ROW_20),
+	CELL_EXITS_ROW(MAZE_ROW_19, MAZE_ROW_20, MAZE_ROW_21),
+	CELL_EXITS_ROW(MAZE_ROW_20, MAZE_ROW_21, MAZE_ROW_22),
+	CELL_EXITS_ROW(MAZE_ROW_21, MAZE_ROW_22, MAZE_ROW_23),
+	CELL_EXITS_ROW(MAZE_ROW_22, MAZE_ROW_23, MAZE_ROW_24),
+	CELL_EXITS_ROW(MAZE_ROW_23, MAZE_ROW_24, MAZE_ROW_25),
+	CELL_EXITS_ROW(MAZE_ROW_24, MAZE_ROW_25, MAZE_ROW_26),
+	CELL_EXITS_ROW(MAZE_ROW_25, MAZE_ROW_26, MAZE_ROW_27),
+	CELL_EXITS_ROW(MAZE_ROW_26, MAZE_ROW_27, MAZE_ROW_28),
+	CELL_EXITS_ROW(MAZE_ROW_27, MAZE_ROW_28, MAZE_ROW_29),
+	CELL_EXITS_ROW(MAZE_ROW_28, MAZE_ROW_29, MAZE_ROW_30),
+	CELL_EXITS_ROW(MAZE_ROW_29, MAZE_ROW_30, MAZE_ROW_OUTSIDE)
+};
+
+// Array to store the location of the walls - same layout as pacdots[] above
+// (bit x of walls[y] is 1 if there is a wall at column x of row y). This is
+// built once from init_game_field by initialise_walls() so that a wall test
+// is a RAM read and a mask instead of a flash read, a multiply and three
+// character comparisons.
+static uint32_t walls[FIELD_HEIGHT];
+static uint8_t walls_initialised = 0;
+
+// Set once the whole game field (including the walls) has been drawn on 
+// the terminal. After that, starting a level only redraws the cells that
+// have changed - see restart_playable_cells().
+static uint8_t field_drawn = 0;
+
+// Mask for each bit within a byte. A variable shift (1UL << x) is a loop
+// on the AVR (up to 30 iterations for a 32 bit value), so row bitboards are
+// tested a byte at a time using this table instead.
+static const uint8_t bit_in_byte[8] = {
+	0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+};
+
 // Initial pacman location and direction
 #define INIT_PACMAN_X 15
 #define INIT_PACMAN_Y 23
 #define INIT_PACMAN_DIRN DIRN_RIGHT
 
-// Location of the ghost's home - ghosts will be every 2 cells
-// starting from the left most position (12,15) to (18,15)
-#define GHOST_HOME_Y 15
-#define GHOST_HOME_X_LEFT 12
-#define GHOST_HOME_X_RIGHT 18
-#define GHOST_HOME_ENTRY_Y 14
-#define GHOST_HOME_ENTRY_X_LEFT 14
-#define GHOST_HOME_ENTRY_X_RIGHT 16
+// The ghosts start in the ghost home (see maze.h) - every 2 cells from 
+// the left most position (12,15) to (18,15)
 #define INIT_GHOST_DIRN DIRN_RIGHT
 
 // Values to represent the contents of a cell (x,y)
@@ -191,11 +349,52 @@ static uint8_t pacman_y;
 // Direction of pacman movement (one of the direction values in game.h)
 static uint8_t pacman_direction;
 
+// Direction the pac-man has been asked to turn but couldn't yet (-1 if 
+// none), the pac-man move ticks left before it is forgotten and the time
+// of the input that asked for it (see request_pacman_direction())
+#define NO_PRETURN (-1)
+static int8_t preturn_direction = NO_PRETURN;
+static uint8_t preturn_ticks_left;
+static uint16_t preturn_input_time;
+static uint16_t turns_made;
+static uint32_t turn_latency_total;
+static uint16_t turn_latency_max;
+static uint16_t preturns_made;
+static uint16_t preturns_expired;
+
 // Locations and directions of the ghosts
 static uint8_t ghost_x[NUM_GHOSTS];
 static uint8_t ghost_y[NUM_GHOSTS];
 static uint8_t ghost_direction[NUM_GHOSTS];
 
+// The corridor (edge of the maze graph - see maze_graph.h) each ghost is
+// following, or NO_MAZE_EDGE, and the number of moves it has made along 
+// it. See corridor_direction().
+static uint8_t ghost_edge[NUM_GHOSTS];
+static uint8_t ghost_edge_step[NUM_GHOSTS];
+
+// Ghost occupancy - same layout as pacdots[] (bit x of ghost_cells[y] is 1
+// if a ghost is at column x of row y). Kept up to date by place_ghost() 
+// whenever a ghost moves so that what_is_at() doesn't have to loop over 
+// the ghosts for every cell it classifies.
+static uint32_t ghost_cells[FIELD_HEIGHT];
+
+// Flow field - the distance (number of moves) from each cell to the 
+// pac-man, following the corridors, as worked out by update_flow_field(). 
+// A ghost only needs to know which neighbouring cell is one move closer 
+// than its own, so only the distance modulo 3 is kept: 0, 1 or 2 (3 means 
+// a wall or a cell the pac-man can't be reached from). The two bits of 
+// each value are held in two bitboards (same layout as pacdots[]) - 248 
+// bytes rather than 961 for a byte per cell. flow_field_x/y is where the
+// pac-man was when it was worked out (FIELD_WIDTH if never).
+static uint32_t flow_field_low_bits[FIELD_HEIGHT];
+static uint32_t flow_field_high_bits[FIELD_HEIGHT];
+static uint8_t flow_field_x = FIELD_WIDTH;
+static uint8_t flow_field_y;
+// CPU cycles taken by the last and the slowest flow field update
+static uint32_t flow_field_cycles;
+static uint32_t flow_field_cycles_max;
+
 // Indicate whether the game is running or not - 1 indicates yes,
 // 0 indicates game over
 static uint8_t game_running;
@@ -210,8 +409,48 @@ static uint16_t last_ghost_score;
 // Pause
 static uint8_t is_game_paused = 0;
 
-// Sounds variables
-static uint32_t sound_enable_time = 0;
+// Top left game field location shown on the LED matrix by the last call
+// to draw_ledmatrix_game() (the view is centred on the pac-man)
+static int8_t ledmatrix_origin_x;
+static int8_t ledmatrix_origin_y;
+
+// CPU cycles taken to build the last LED matrix frame
+static uint16_t ledmatrix_render_cycles;
+
+// How the walls are drawn on the terminal (WALLS_UNICODE or 
+// WALLS_DEC_GRAPHICS), the cost of the last full draw of the field (the
+// first initialise_game_level() or redraw_game_field()) in each mode 
+// (indexed by the mode), and the cost of the last level restart (a later
+// initialise_game_level(), which only redraws the cells that changed)
+static uint8_t wall_graphics_mode = WALLS_UNICODE;
+static uint32_t level_draw_bytes[2];
+static uint16_t level_draw_ms[2];
+static uint32_t level_restart_bytes;
+static uint16_t level_restart_ms;
+
+// Cell updates that weren't sent to the terminal because the serial output
+// buffer was nearly full (so sending them would have held up the game).
+// Only the cell is remembered - when there is room it is drawn as it is 
+// then, so further updates to a cell that is waiting are coalesced into
+// one. Deferral is turned off while the whole field is being drawn and 
+// when the game is over (when waiting doesn't matter).
+#define MAX_DEFERRED_CELLS 16
+// Cell updates are deferred when there is less room than this in the 
+// output buffer. A cell takes at most 24 bytes (cursor move, attributes,
+// a 3 byte glyph and an attribute reset) - the rest leaves room for a 
+// score update.
+#define CELL_UPDATE_SPACE 48
+static uint8_t deferred_cell_x[MAX_DEFERRED_CELLS];
+static uint8_t deferred_cell_y[MAX_DEFERRED_CELLS];
+static uint8_t num_deferred_cells;
+static uint8_t cell_deferral_enabled;
+static uint16_t cells_deferred;
+static uint16_t cells_coalesced;
+
+// Power pellets start in columns 1 and 29 of rows 6 and 23
+#define POWER_PELLET_ROW_1 6
+#define POWER_PELLET_ROW_2 23
+#define POWER_PELLET_COLUMNS ((1UL << 1) | (1UL << 29))
 
 // Load Variables
 uint16_t load_score[1];
@@ -241,13 +480,26 @@ uint8_t load_ghost_dirn[NUM_GHOSTS];
 ///////////////////////////////////////////////////////////
 // Private Functions
 //
+// row_bit_is_set() returns non-zero if bit x is set in the given row
+// bitboard (e.g. walls[y] or pacdots[y]). The AVR is little endian so
+// bit x lives in byte x/8 of the 32 bit value.
+static uint8_t row_bit_is_set(const uint32_t* row, uint8_t x) {
+	return ((const uint8_t*)row)[x >> 3] & bit_in_byte[x & 7];
+}
+
+// Set or clear bit x in the given row bitboard
+static void set_row_bit(uint32_t* row, uint8_t x) {
+	((uint8_t*)row)[x >> 3] |= bit_in_byte[x & 7];
+}
+
+static void clear_row_bit(uint32_t* row, uint8_t x) {
+	((uint8_t*)row)[x >> 3] &= ~bit_in_byte[x & 7];
+}
+
 // is_wall_at() returns true (1) if there is a wall at the given 
 // game location, 0 otherwise
 static int8_t is_wall_at (uint8_t x, uint8_t y) {
-	// Get information about any wall in that position
-	char wall_character = pgm_read_byte(& init_game_field[y * FIELD_WIDTH + x]);
-	return (wall_character != ' ' && wall_character != '.'
-			&& wall_character != 'P');
+	return row_bit_is_set(&walls[y], x) != 0;
 }
 
 // is_pacman_at() returns true(1) if the pacman is at the given 
@@ -259,29 +511,44 @@ static int8_t is_pacman_at(uint8_t x, uint8_t y) {
 // is_pacdot_at() returns true (1) if there is a pacdot at the given
 // game location, 0 otherwise
 static int8_t is_pacdot_at (uint8_t x, uint8_t y) {
-	// Get the details for the row
-	uint32_t dots_on_row = pacdots[y];
 	// Extract the value for the column x (which is in bit x)
-	if(dots_on_row & (1UL<< x)) {
-		return 1;
-	} else {
-		return 0;
-	}
+	return row_bit_is_set(&pacdots[y], x) != 0;
 }
 
 static int8_t is_power_pellet_at(uint8_t x, uint8_t y) {
 	if ((y == 6 || y == 23) && (x == 1 || x == 29)) {
-		uint32_t dots_on_row = pacdots[y];
-		
-		if(dots_on_row & (1UL << x)) {
-			return 1;
-		} else {
-			return 0;
-		}
+		return row_bit_is_set(&pacdots[y], x) != 0;
 	}
 	return 0;
 }
 
+// ghost_number_at() returns the number of the ghost at the given location
+// or -1 if there is none. Only called once ghost_cells[] says there is a 
+// ghost in the cell, so the loop is only run for occupied cells.
+static int8_t ghost_number_at(uint8_t x, uint8_t y) {
+	for(int8_t i = 0; i < NUM_GHOSTS; i++) {
+		if(x == ghost_x[i] && y == ghost_y[i]) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// place_ghost() moves the given ghost to (x,y) and updates the ghost 
+// occupancy bitboard. Ghosts can (briefly) share a cell, e.g. when a 
+// ghost is sent home on to another ghost, so the old cell is only cleared
+// if no other ghost remains there.
+static void place_ghost(uint8_t ghostnum, uint8_t x, uint8_t y) {
+	uint8_t old_x = ghost_x[ghostnum];
+	uint8_t old_y = ghost_y[ghostnum];
+	ghost_x[ghostnum] = x;
+	ghost_y[ghostnum] = y;
+	if(ghost_number_at(old_x, old_y) < 0) {
+		clear_row_bit(&ghost_cells[old_y], old_x);
+	}
+	set_row_bit(&ghost_cells[y], x);
+}
+
 // Returns true (1) if the given location is the home of the ghosts
 // (this includes the entry to the home of the ghosts)
 static int8_t is_ghost_home(uint8_t x, uint8_t y) {
@@ -318,7 +585,7 @@ void update_score(uint8_t value) {
 // is initialised.
 static void eat_pacdot(uint8_t value) {
 
-	pacdots[pacman_y] ^= 1UL << pacman_x;
+	clear_row_bit(&pacdots[pacman_y], pacman_x);
 	
 	// Decrement number of pacdots
 	num_pacdots -= 1;
@@ -339,20 +606,20 @@ static void eat_pacdot(uint8_t value) {
 // what_is_at(x,y) returns
 //		CELL_EMPTY, CELL_CONTAINS_PACDOT, CELL_CONTAINS_PACMAN, CELL_IS_WALL,
 //		CELL_IS_GHOST_HOME or the ghost number if the cell contains a ghost
+// Each test is a comparison or a single bitboard lookup so the cost doesn't
+// depend on the number of ghosts.
 static int8_t what_is_at(uint8_t x, uint8_t y) {
 	if(is_pacman_at(x,y)) {
 		return CELL_CONTAINS_PACMAN;
-	} else { // Check for ghosts next - these take priority over dots
+	} else if(row_bit_is_set(&ghost_cells[y], x)) {
+		// Check for ghosts next - these take priority over dots
 		// BUT note that there may be a pacdot at the same location
-		for(int8_t i = 0; i < NUM_GHOSTS; i++) {
-			if(x == ghost_x[i] && y == ghost_y[i]) {
-				return i;	// ghost number
-			}
-		}
+		return ghost_number_at(x, y);
 	}
-	if (is_power_pellet_at(x, y)) {
-		return CELL_CONTAINS_POWER_PELLET;
-	} else if (is_pacdot_at(x,y)) {
+	if(row_bit_is_set(&pacdots[y], x)) {
+		if(is_power_pellet_at(x, y)) {
+			return CELL_CONTAINS_POWER_PELLET;
+		}
 		return CELL_CONTAINS_PACDOT;
 	} else if (is_wall_at(x,y)) {
 		return CELL_IS_WALL;
@@ -409,14 +676,42 @@ static int8_t what_is_in_dirn(uint8_t x, uint8_t y, uint8_t direction) {
 	return what_is_at(x + delta_x, y + delta_y);
 }
 
+// cell_exits() returns the exits from cell (x,y) - see cell_exits_table.
+static uint8_t cell_exits(uint8_t x, uint8_t y) {
+	uint8_t exits = pgm_read_byte(&cell_exits_table[y][x >> 1]);
+	if(x & 1) {
+		return exits >> 4;
+	}
+	return exits & 0x0F;
+}
+
+// ghost_exits() returns the exits from cell (x,y) that a ghost can use, 
+// ignoring what is in the cells. This is cell_exits() except that a ghost
+// can't move into the ghost home from outside it. (The only way into the
+// home is down from the row above its entry.)
+static uint8_t ghost_exits(uint8_t x, uint8_t y) {
+	uint8_t exits = cell_exits(x, y);
+	if(y == GHOST_HOME_ENTRY_Y - 1 && x >= GHOST_HOME_ENTRY_X_LEFT 
+			&& x <= GHOST_HOME_ENTRY_X_RIGHT) {
+		exits &= ~(1 << DIRN_DOWN);
+	}
+	return exits;
+}
+
+// is_ghost_in_the_way() returns true (1) if there is a ghost (and not the
+// pac-man) at (x,y) - i.e. another ghost can't move there.
+static int8_t is_ghost_in_the_way(uint8_t x, uint8_t y) {
+	return row_bit_is_set(&ghost_cells[y], x) && !is_pacman_at(x, y);
+}
+
 // determine_dirns_ghost_can_move_in()
 // Returns a number that indicates whether a ghost at the given x,y location
 // can move in each direction. The lower 4 bits of the return value will each
 // be 0 or 1 - 0 means can't move in the direction, 1 means can move. The bit
 // positions are
 // - 0 (DIRN_LEFT) (least significant) - left
-// - 1 (DIRN_RIGHT) - right
-// - 2 (DIRN_UP) - up
+// - 1 (DIRN_UP) - up
+// - 2 (DIRN_RIGHT) - right
 // - 3 (DIRN_DOWN) - down
 // Movement in the given direction can only happen if the cell is one of
 // - the pacman
@@ -425,21 +720,23 @@ static int8_t what_is_in_dirn(uint8_t x, uint8_t y, uint8_t direction) {
 // It can not move there if the cell is a ghost or a wall.
 // If we're in the ghost home we can move to another cell in the ghost home.
 // If we're outside the ghost home we can't move into it.
+// The walls (and ghost home) are looked up in a table - only the ghosts 
+// need to be checked.
 static int8_t determine_dirns_ghost_can_move_in(uint8_t x, uint8_t y) {
-	int8_t return_value = 0;
-	int8_t posn_is_in_ghost_home = is_ghost_home(x,y);
-	for(int8_t dirn = DIRN_LEFT; dirn <= DIRN_DOWN; dirn++) {
-		int8_t adjacent_cell_contents = what_is_in_dirn(x,y,dirn);
-		
-		if(adjacent_cell_contents < CELL_IS_WALL) {
-			// cell is empty or pacdot or pacman
-			return_value |= (1 << dirn);
-		} else if(posn_is_in_ghost_home && adjacent_cell_contents == CELL_IS_GHOST_HOME) {
-			// we're in the ghost home and can move to an empty cell in the ghost home
-			return_value |= (1 << dirn);
-		} 
+	uint8_t exits = ghost_exits(x, y);
+	if((exits & (1 << DIRN_LEFT)) && is_ghost_in_the_way(x - 1, y)) {
+		exits &= ~(1 << DIRN_LEFT);
+	}
+	if((exits & (1 << DIRN_UP)) && is_ghost_in_the_way(x, y - 1)) {
+		exits &= ~(1 << DIRN_UP);
+	}
+	if((exits & (1 << DIRN_RIGHT)) && is_ghost_in_the_way(x + 1, y)) {
+		exits &= ~(1 << DIRN_RIGHT);
+	}
+	if((exits & (1 << DIRN_DOWN)) && is_ghost_in_the_way(x, y + 1)) {
+		exits &= ~(1 << DIRN_DOWN);
 	}
-	return return_value;
+	return exits;
 }
 
 // direction_to_pacman() is called for a ghost position and we return a direction
@@ -507,6 +804,198 @@ static int8_t direction_to_pacman(uint8_t x, uint8_t y) {
 	return -1;
 }
 
+// Mask of the bits used for the columns of the game field in a row bitboard
+#define FIELD_ROW_MASK ((1UL << FIELD_WIDTH) - 1)
+
+// flow_field_cells() returns the cells in row y whose flow field value is 
+// the given value (0 to 3) as a row bitboard.
+static uint32_t flow_field_cells(uint8_t y, uint8_t value) {
+	uint32_t low = flow_field_low_bits[y];
+	uint32_t high = flow_field_high_bits[y];
+	return (value & 1 ? low : ~low) & (value & 2 ? high : ~high) & FIELD_ROW_MASK;
+}
+
+static uint8_t flow_field_value(uint8_t x, uint8_t y) {
+	return (row_bit_is_set(&flow_field_low_bits[y], x) ? 1 : 0) | 
+			(row_bit_is_set(&flow_field_high_bits[y], x) ? 2 : 0);
+}
+
+// update_flow_field() works out the flow field for the pac-man's current
+// location, if it has moved since the last time. This is a breadth first
+// search that handles a whole row of cells at a time: the cells at 
+// distance d+1 are the unreached cells that aren't walls next to a cell at
+// distance d. All cells with value d mod 3 can be used for this (not just
+// those at distance d) because every neighbour of a cell at a distance 
+// less than d has already been reached. Only the rows either side of the 
+// rows reached by the previous step need to be looked at. Ghosts aren't 
+// treated as obstacles (they move) and, unlike the pac-man, ghosts can't 
+// use the tunnel so the field doesn't wrap around.
+// The whole field is rebuilt rather than patched: when the pac-man moves
+// one cell every distance can change by one, so an incremental update 
+// would touch about as many cells as this does. The search takes at most
+// 57 steps and 934 row operations (the worst pac-man cell in this maze),
+// roughly 150 cycles each - under 20 ms. It runs at most once per pac-man
+// move (every 400 ms) in the main loop with interrupts on, so the 1 ms 
+// timer tick is never held up. get_flow_field_cycles_max() reports the 
+// worst case measured on the board.
+static void update_flow_field(void) {
+	if(flow_field_x == pacman_x && flow_field_y == pacman_y) {
+		return;
+	}
+	uint32_t start_cycles = get_current_cycles();
+	
+	// Start with every cell unreached (3) except the pac-man's (0)
+	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
+		flow_field_low_bits[y] = FIELD_ROW_MASK;
+		flow_field_high_bits[y] = FIELD_ROW_MASK;
+	}
+	clear_row_bit(&flow_field_low_bits[pacman_y], pacman_x);
+	clear_row_bit(&flow_field_high_bits[pacman_y], pacman_x);
+	
+	uint8_t first_row = pacman_y;	// rows reached by the last step
+	uint8_t last_row = pacman_y;
+	uint8_t value = 0;				// distance mod 3 of the last step
+	uint8_t reached = 1;
+	while(reached) {
+		uint8_t next_value = (value == 2) ? 0 : value + 1;
+		uint8_t from_row = (first_row == 0) ? 0 : first_row - 1;
+		uint8_t to_row = (last_row == FIELD_HEIGHT - 1) ? last_row : last_row + 1;
+		reached = 0;
+		// Cells with the last value in the row above, this row and the row below
+		uint32_t above = (from_row == 0) ? 0 : flow_field_cells(from_row - 1, value);
+		uint32_t here = flow_field_cells(from_row, value);
+		for(uint8_t y = from_row; y <= to_row; y++) {
+			uint32_t below = (y == FIELD_HEIGHT - 1) ? 0 : flow_field_cells(y + 1, value);
+			uint32_t unreached = flow_field_cells(y, 3) & ~walls[y];
+			uint32_t new_cells = ((here << 1) | (here >> 1) | above | below) & unreached;
+			if(new_cells) {
+				// Change these cells from 3 (both bits set) to next_value
+				if(!(next_value & 1)) {
+					flow_field_low_bits[y] &= ~new_cells;
+				}
+				if(!(next_value & 2)) {
+					flow_field_high_bits[y] &= ~new_cells;
+				}
+				if(!reached) {
+					first_row = y;
+					reached = 1;
+				}
+				last_row = y;
+			}
+			above = here;
+			here = below;
+		}
+		value = next_value;
+	}
+	flow_field_x = pacman_x;
+	flow_field_y = pacman_y;
+	
+	flow_field_cycles = get_current_cycles() - start_cycles;
+	if(flow_field_cycles > flow_field_cycles_max) {
+		flow_field_cycles_max = flow_field_cycles;
+	}
+}
+
+// direction_along_flow_field() returns a direction (from those set in
+// dirn_options - see determine_dirns_ghost_can_move_in()) that takes a 
+// ghost at (x,y) one move closer to the pac-man along the shortest path,
+// or -1 if none of them do (e.g. another ghost is in the way).
+static int8_t direction_along_flow_field(uint8_t x, uint8_t y, int8_t dirn_options) {
+	update_flow_field();
+	uint8_t value = flow_field_value(x, y);
+	if(value == 3) {
+		return -1;
+	}
+	// Value for a cell one move closer
+	uint8_t closer_value = (value == 0) ? 2 : value - 1;
+	if((dirn_options & (1 << DIRN_LEFT)) && flow_field_value(x - 1, y) == closer_value) {
+		return DIRN_LEFT;
+	}
+	if((dirn_options & (1 << DIRN_RIGHT)) && flow_field_value(x + 1, y) == closer_value) {
+		return DIRN_RIGHT;
+	}
+	if((dirn_options & (1 << DIRN_UP)) && flow_field_value(x, y - 1) == closer_value) {
+		return DIRN_UP;
+	}
+	if((dirn_options & (1 << DIRN_DOWN)) && flow_field_value(x, y + 1) == closer_value) {
+		return DIRN_DOWN;
+	}
+	return -1;
+}
+
+// maze_node_at() returns the maze graph node at (x,y) - a junction, dead
+// end or end of the tunnel - or NO_MAZE_NODE if there isn't one there.
+static uint8_t maze_node_at(uint8_t x, uint8_t y) {
+	uint32_t nodes = pgm_read_dword(&maze_node_cells[y]);
+	if(!row_bit_is_set(&nodes, x)) {
+		return NO_MAZE_NODE;
+	}
+	// Nodes are numbered along each row in turn
+	uint8_t node = pgm_read_byte(&maze_node_row_first[y]);
+	for(uint8_t i = 0; i < x; i++) {
+		if(row_bit_is_set(&nodes, i)) {
+			node++;
+		}
+	}
+	return node;
+}
+
+// maze_edge_direction() returns the direction of move number step (from 0)
+// along the given edge of the maze graph.
+static uint8_t maze_edge_direction(uint8_t edge, uint8_t step) {
+	uint16_t index = pgm_read_word(&maze_edges[edge].path) + step;
+	return (pgm_read_byte(&maze_edge_paths[index >> 2]) >> ((index & 3) << 1)) & 3;
+}
+
+// corridor_direction() returns the direction a ghost following a corridor
+// should move in next - read from the maze graph, after a single check 
+// that there is no ghost in the way. -1 is returned if the ghost isn't
+// following a corridor, has reached the node at the end of it or is 
+// blocked by another ghost - the ghost must make a decision.
+static int8_t corridor_direction(uint8_t ghostnum) {
+	uint8_t edge = ghost_edge[ghostnum];
+	uint8_t step = ghost_edge_step[ghostnum];
+	if(edge == NO_MAZE_EDGE || step == pgm_read_byte(&maze_edges[edge].length)) {
+		return -1;
+	}
+	uint8_t dirn = maze_edge_direction(edge, step);
+	uint8_t x = ghost_x[ghostnum];
+	uint8_t y = ghost_y[ghostnum];
+	switch(dirn) {
+		case DIRN_LEFT:		x--; break;
+		case DIRN_UP:		y--; break;
+		case DIRN_RIGHT:	x++; break;
+		case DIRN_DOWN:		y++; break;
+	}
+	if(is_ghost_in_the_way(x, y)) {
+		ghost_edge[ghostnum] = NO_MAZE_EDGE;
+		return -1;
+	}
+	ghost_edge_step[ghostnum] = step + 1;
+	return dirn;
+}
+
+// start_corridor() is called when a ghost has decided to move in the given
+// direction (-1 if it can't move). If it is at a node of the maze graph
+// it will follow the corridor that leaves the node in that direction to
+// the next node. Anywhere else (leaving the ghost home, or after being 
+// blocked part way along a corridor) it keeps deciding until it reaches a
+// node.
+static void start_corridor(uint8_t ghostnum, int8_t dirn) {
+	uint8_t node;
+	if(ghost_edge[ghostnum] != NO_MAZE_EDGE) {
+		// At the end of the corridor it was following
+		node = pgm_read_byte(&maze_edges[ghost_edge[ghostnum]].to);
+	} else {
+		node = maze_node_at(ghost_x[ghostnum], ghost_y[ghostnum]);
+	}
+	ghost_edge[ghostnum] = NO_MAZE_EDGE;
+	if(dirn >= 0 && node != NO_MAZE_NODE) {
+		ghost_edge[ghostnum] = pgm_read_byte(&maze_node_edges[node][dirn]);
+		ghost_edge_step[ghostnum] = 1;
+	}
+}
+
 // determine_ghost_direction_to_move()
 // 
 // Determine the direction the given ghost (0 to 3) should move in.
@@ -533,7 +1022,14 @@ static int8_t determine_ghost_direction_to_move(uint8_t ghostnum) {
 	}
 	switch(ghostnum) {
 		case 0:
-			// Ghost 0 will always try to move towards the pacman
+			// Ghost 0 will always try to move towards the pacman - along the
+			// shortest path if it can, otherwise by the more direct route
+			{
+				int8_t dirn = direction_along_flow_field(x, y, dirn_options);
+				if(dirn >= 0) {
+					return dirn;
+				}
+			}
 			return direction_to_pacman(x, y);
 			break;
 		case 1:
@@ -585,6 +1081,21 @@ static int8_t determine_ghost_direction_to_move(uint8_t ghostnum) {
 	return -1;	
 }
 
+// next_ghost_direction() returns the direction the given ghost should move
+// in next, or -1 if it can't move. Ghosts only make a decision (see 
+// determine_ghost_direction_to_move()) at the nodes of the maze graph - 
+// junctions and dead ends. Once a ghost has chosen a corridor it follows
+// it to the next node without turning back, unless another ghost blocks
+// it.
+static int8_t next_ghost_direction(uint8_t ghostnum) {
+	int8_t dirn = corridor_direction(ghostnum);
+	if(dirn < 0) {
+		dirn = determine_ghost_direction_to_move(ghostnum);
+		start_corridor(ghostnum, dirn);
+	}
+	return dirn;
+}
+
 uint8_t game_paused_status(void) {
 	return is_game_paused;
 }
@@ -593,74 +1104,174 @@ void change_game_paused(void) {
 	is_game_paused = ~is_game_paused;
 }
 
+// wall_glyph() returns the string to output for the given character 
+// from init_game_field in the current wall graphics mode, or NULL if the
+// character isn't a wall. (In WALLS_DEC_GRAPHICS mode the terminal must 
+// be in line drawing mode when the string is output.)
+#define WALL_GLYPH(unicode, dec) \
+		((wall_graphics_mode == WALLS_DEC_GRAPHICS) ? (dec) : (unicode))
+static const char* wall_glyph(char wall_character) {
+	switch(wall_character) {
+		case '-':	return WALL_GLYPH(LINE_HORIZONTAL, DEC_LINE_HORIZONTAL);
+		case '|':	return WALL_GLYPH(LINE_VERTICAL, DEC_LINE_VERTICAL);
+		case 'F':	return WALL_GLYPH(LINE_DOWN_AND_RIGHT, DEC_LINE_DOWN_AND_RIGHT);
+		case '7':	return WALL_GLYPH(LINE_DOWN_AND_LEFT, DEC_LINE_DOWN_AND_LEFT);
+		case 'L':	return WALL_GLYPH(LINE_UP_AND_RIGHT, DEC_LINE_UP_AND_RIGHT);
+		case 'J':	return WALL_GLYPH(LINE_UP_AND_LEFT, DEC_LINE_UP_AND_LEFT);
+		case '>':	return WALL_GLYPH(LINE_VERTICAL_AND_RIGHT, DEC_LINE_VERTICAL_AND_RIGHT);
+		case '<':	return WALL_GLYPH(LINE_VERTICAL_AND_LEFT, DEC_LINE_VERTICAL_AND_LEFT);
+		case '^':	return WALL_GLYPH(LINE_HORIZONTAL_AND_UP, DEC_LINE_HORIZONTAL_AND_UP);
+		case 'v':	return WALL_GLYPH(LINE_HORIZONTAL_AND_DOWN, DEC_LINE_HORIZONTAL_AND_DOWN);
+		case '+':	return WALL_GLYPH(LINE_VERTICAL_AND_HORIZONTAL, DEC_LINE_VERTICAL_AND_HORIZONTAL);
+		default:	return NULL;
+	}
+}
+
 // draw_initial_game_field()
 static void draw_initial_game_field(void) {
 	clear_terminal();
 	normal_display_mode();
 	hide_cursor();
 	move_cursor(1,1);	// Start at top left
+	if(wall_graphics_mode == WALLS_DEC_GRAPHICS) {
+		// Spaces, pac-dots and power pellets are the same in both
+		// character sets so we can stay in line drawing mode for the 
+		// whole field
+		enter_line_drawing_mode();
+	}
 	uint16_t wall_array_index = 0;  // row_number * 31 + column_number, i.e. 31*x+y
 	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
 		for(uint8_t x = 0; x < FIELD_WIDTH; x++) {
 			char wall_character = pgm_read_byte(&init_game_field[wall_array_index]);
-			switch(wall_character) {
-				case '-':	printf("%s", LINE_HORIZONTAL); break;
-				case '|':	printf("%s", LINE_VERTICAL); break;
-				case 'F':	printf("%s", LINE_DOWN_AND_RIGHT); break;
-				case '7':	printf("%s", LINE_DOWN_AND_LEFT); break;
-				case 'L':	printf("%s", LINE_UP_AND_RIGHT); break;
-				case 'J':	printf("%s", LINE_UP_AND_LEFT); break;
-				case '>':	printf("%s", LINE_VERTICAL_AND_RIGHT); break;
-				case '<':	printf("%s", LINE_VERTICAL_AND_LEFT); break;
-				case '^':	printf("%s", LINE_HORIZONTAL_AND_UP); break;
-				case 'v':	printf("%s", LINE_HORIZONTAL_AND_DOWN); break;
-				case '+':	printf("%s", LINE_VERTICAL_AND_HORIZONTAL); break;
-				case ' ':	printf(" "); break;
-				case 'P':	
-					set_display_attribute(FG_GREEN);
-					printf("O");
-					set_display_attribute(FG_WHITE);
-					break;
-				case '.':	printf("."); break;	// pac-dot
-				default:	printf("x"); break;	// shouldn't happen but we show an x in case it does
+			const char* glyph = wall_glyph(wall_character);
+			if(glyph) {
+				put_glyph(glyph);
+			} else {
+				switch(wall_character) {
+					case ' ':	put_glyph(" "); break;
+					case 'P':	
+						set_display_attribute(FG_GREEN);
+						put_glyph("O");
+						normal_display_mode();
+						break;
+					case '.':	put_glyph("."); break;	// pac-dot
+					default:	put_glyph("?"); break;	// shouldn't happen but we show a ? in case it does
+				}
 			}
 			wall_array_index++;
 		}
 		printf("\n");
 	}
+	if(wall_graphics_mode == WALLS_DEC_GRAPHICS) {
+		exit_line_drawing_mode();
+	}
+	field_drawn = 1;
 }
 
-static void initialise_pacdots(void) {
-	num_pacdots = 0;
-	uint16_t wall_array_index = 0;  // row_number * 31 + column_number, i.e. 31*x+y
+// draw_walls() redraws just the walls, leaving the rest of the field as
+// it is. Runs of walls are output without any cursor movement between 
+// them.
+static void draw_walls(void) {
+	normal_display_mode();
+	hide_cursor();
+	if(wall_graphics_mode == WALLS_DEC_GRAPHICS) {
+		enter_line_drawing_mode();
+	}
+	uint16_t wall_array_index = 0;
 	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
-		pacdots[y] = 0;
+		for(uint8_t x = 0; x < FIELD_WIDTH; x++) {
+			const char* glyph = wall_glyph(pgm_read_byte(&init_game_field[wall_array_index]));
+			if(glyph) {
+				move_cursor(x+1, y+1);
+				put_glyph(glyph);
+			}
+			wall_array_index++;
+		}
+	}
+	if(wall_graphics_mode == WALLS_DEC_GRAPHICS) {
+		exit_line_drawing_mode();
+	}
+}
+
+// Build the walls[] bitboard from init_game_field. Any character other
+// than a space, a pac-dot or a power pellet is a wall. The maze never
+// changes so this only needs to happen the first time through.
+static void initialise_walls(void) {
+	if(walls_initialised) {
+		return;
+	}
+	uint16_t wall_array_index = 0;  // row_number * 31 + column_number
+	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
+		walls[y] = 0;
 		for(uint8_t x = 0; x < FIELD_WIDTH; x++) {
 			char wall_character = pgm_read_byte(&init_game_field[wall_array_index]);
-			if(wall_character == '.' || wall_character == 'P') {
-				pacdots[y] |= (1UL<<x);
-				num_pacdots++;
+			if(wall_character != ' ' && wall_character != '.' && wall_character != 'P') {
+				walls[y] |= (1UL<<x);
 			}
 			wall_array_index++;
 		}
-	}	
+	}
+	walls_initialised = 1;
+}
+
+// initial_pacdots_row() returns the pac-dots (and power pellets) that
+// row y starts a level with, in the same form as pacdots[y].
+static uint32_t initial_pacdots_row(uint8_t y) {
+	return pgm_read_dword(&initial_pacdots[y]);
+}
+
+static void initialise_pacdots(void) {
+	memcpy_P(pacdots, initial_pacdots, sizeof(pacdots));
+	num_pacdots = pgm_read_word(&initial_num_pacdots);
+}
+
+// defer_cell() is called by each function that draws a cell of the field.
+// It returns 1 if the cell shouldn't be drawn now (the serial link is 
+// busy, or the cell is already waiting to be drawn) in which case the
+// cell is remembered and draw_deferred_cells() draws it later. Returns 0
+// if the cell should be drawn now.
+static uint8_t defer_cell(uint8_t x, uint8_t y) {
+	if(!cell_deferral_enabled || !game_running) {
+		return 0;
+	}
+	for(uint8_t i = 0; i < num_deferred_cells; i++) {
+		if(deferred_cell_x[i] == x && deferred_cell_y[i] == y) {
+			cells_coalesced++;
+			return 1;
+		}
+	}
+	if(num_deferred_cells < MAX_DEFERRED_CELLS && 
+			serial_tx_space() < CELL_UPDATE_SPACE) {
+		deferred_cell_x[num_deferred_cells] = x;
+		deferred_cell_y[num_deferred_cells] = y;
+		num_deferred_cells++;
+		cells_deferred++;
+		return 1;
+	}
+	return 0;
 }
 
 // Erase the pixel at the given location - presumably because the 
 // ghost or the pac-man has moved out of this space. If there is 
 // still a pac-dot at this space, we output a dot, otherwise we
-// output a space. It is assumed that we are in normal video mode.
+// output a space. (The terminal remembers the display mode so 
+// normal_display_mode() only sends anything if we're not already in
+// normal video mode.)
 static void erase_pixel_at(uint8_t x, uint8_t y) {
+	if(defer_cell(x, y)) {
+		return;
+	}
 	move_cursor(x+1, y+1);
+	normal_display_mode();
 	
 	if (is_power_pellet_at(x, y)) {
 		set_display_attribute(FG_GREEN);
-		printf("O");
-	} else if(is_pacdot_at(x,y)) {
+		put_glyph("O");
 		normal_display_mode();
-		printf(".");
+	} else if(is_pacdot_at(x,y)) {
+		put_glyph(".");
  	} else {
-		printf(" ");
+		put_glyph(" ");
 	 }
 }
 
@@ -668,15 +1279,21 @@ static void erase_pixel_at(uint8_t x, uint8_t y) {
 // to draw the pac-man is based on the direction it is currently
 // facing.
 static void draw_pacman_at(uint8_t x, uint8_t y) {
+	if(defer_cell(x, y)) {
+		return;
+	}
 	move_cursor(x+1,y+1);
 	set_display_attribute(PACMAN_COLOUR);
-	printf("%s", pacman_characters[pacman_direction]);
+	put_glyph(pacman_characters[pacman_direction]);
 	normal_display_mode();
 }
 
 // ghostnum is assumed to be in the range 0..NUM_GHOSTS-1
 // x and y values are assumed to be valid
 static void draw_ghost_at(uint8_t ghostnum, uint8_t x, uint8_t y) {
+	if(defer_cell(x, y)) {
+		return;
+	}
 	move_cursor(x+1,y+1);
 	// change the background colour to the colour of the given ghost
 	set_display_attribute(ghost_colours[ghostnum]);
@@ -684,11 +1301,11 @@ static void draw_ghost_at(uint8_t ghostnum, uint8_t x, uint8_t y) {
 	// we output a space (which will be shown as a block in reverse video)
 	if (is_power_pellet_at(x,y)) {
 		set_display_attribute(FG_BLACK);
-		printf("O");
+		put_glyph("O");
 	} else if(is_pacdot_at(x,y)) {
-		printf(".");
+		put_glyph(".");
 	} else {
-		printf(" ");
+		put_glyph(" ");
 	}
 	// Return to normal display mode to ensure we don't use this
 	// background colour for any other printing
@@ -696,45 +1313,95 @@ static void draw_ghost_at(uint8_t ghostnum, uint8_t x, uint8_t y) {
 }
 
 static void draw_power_pellet_ghost_at(uint8_t ghostnum, uint8_t x, uint8_t y) {
+		if(defer_cell(x, y)) {
+			return;
+		}
 		move_cursor(x+1,y+1);
 		// change the background colour to the colour of the given ghost
 		set_display_attribute(BG_BLUE);
 		// If there is a pac-dot at this location we output a "." otherwise
 		// we output a space (which will be shown as a block in reverse video)
 		if(is_pacdot_at(x,y)) {
-			printf(".");
+			put_glyph(".");
 		} else {
-			printf(" ");
+			put_glyph(" ");
 		}
 		// Return to normal display mode to ensure we don't use this
 		// background colour for any other printing
 		normal_display_mode();
 }
 
-/////////////////////////////////////////////////////////////////////////
-/////////////////////////////////////////////////////////////////////////
-// Public Functions
-void initialise_game_level(void) {
-	draw_initial_game_field();
-	initialise_pacdots();
-	pacman_x = INIT_PACMAN_X;
-	pacman_y = INIT_PACMAN_Y;
-	pacman_direction = INIT_PACMAN_DIRN;
-	draw_pacman_at(pacman_x, pacman_y);
-	for(int8_t i = 0; i < NUM_GHOSTS; i++) {
-		ghost_x[i] = GHOST_HOME_X_LEFT + 2*i;
-		ghost_y[i] = GHOST_HOME_Y;
-		ghost_direction[i] = INIT_GHOST_DIRN;
-		draw_ghost_at(i, ghost_x[i], ghost_y[i]);
+// Draw the given cell as it is now - the pac-man, a ghost or what the
+// pac-man and ghosts have left behind
+static void draw_cell(uint8_t x, uint8_t y) {
+	if(is_pacman_at(x, y)) {
+		draw_pacman_at(x, y);
+	} else if(row_bit_is_set(&ghost_cells[y], x)) {
+		int8_t ghostnum = ghost_number_at(x, y);
+		if(power_pellet_eaten) {
+			draw_power_pellet_ghost_at(ghostnum, x, y);
+		} else {
+			draw_ghost_at(ghostnum, x, y);
+		}
+	} else {
+		erase_pixel_at(x, y);
 	}
-	
-	// Display Initial Scores/Remaining pacdots
+}
+
+// Draw all the deferred cells (waiting for room in the output buffer if 
+// need be) and stop deferring cell updates. Used before the whole field
+// is drawn, so the screen matches the game state when it starts.
+static void flush_deferred_cells(void) {
+	cell_deferral_enabled = 0;
+	for(uint8_t i = 0; i < num_deferred_cells; i++) {
+		draw_cell(deferred_cell_x[i], deferred_cell_y[i]);
+	}
+	num_deferred_cells = 0;
+}
+
+// restart_playable_cells() is used instead of initialise_pacdots() and
+// draw_initial_game_field() when a level is restarted and the field is
+// already on the terminal. The walls never change, and a cell that isn't
+// a wall only needs to be redrawn if its pac-dot is being restored or the
+// pac-man or a ghost is (still) shown there - so this must be called 
+// before they are moved back to their starting positions. Runs of 
+// adjacent cells need no cursor movement and short gaps are skipped with
+// a relative cursor move. Anything to the right of the field (messages 
+// and statistics) is cleared.
+static void restart_playable_cells(void) {
+	normal_display_mode();
+	hide_cursor();
+	num_pacdots = pgm_read_word(&initial_num_pacdots);
+	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
+		uint32_t initial_row = initial_pacdots_row(y);
+		uint32_t cells_to_draw = (pacdots[y] ^ initial_row) | ghost_cells[y];
+		pacdots[y] = initial_row;
+		if(y == pacman_y) {
+			set_row_bit(&cells_to_draw, pacman_x);
+		}
+		for(uint8_t x = 0; x < FIELD_WIDTH; x++) {
+			if(row_bit_is_set(&cells_to_draw, x)) {
+				erase_pixel_at(x, y);
+			}
+		}
+		move_cursor(FIELD_WIDTH + 1, y + 1);
+		clear_to_end_of_line();
+	}
+	// The statistics go further down than the field
+	for(uint8_t y = FIELD_HEIGHT + 1; y <= PERFORMANCE_STATS_LAST_ROW; y++) {
+		move_cursor(FIELD_WIDTH + 1, y);
+		clear_to_end_of_line();
+	}
+}
+
+// Display the scores, remaining pacdots etc. to the right of the field
+static void draw_status_text(uint8_t lives) {
 	move_cursor(33, 1);
 	printf("%s", "Remaining number of pac-dots: ");
 	printf("%d", num_pacdots);
 	move_cursor(33, 2);
 	printf("%s", "Lives: ");
-	printf("%d", 3);
+	printf("%d", lives);
 	move_cursor(33, 3);
 	printf("%10s", "Score");
 	move_cursor(33, 4);
@@ -751,6 +1418,75 @@ void initialise_game_level(void) {
 	}
 }
 
+/////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////
+// Public Functions
+void initialise_game_level(void) {
+	uint32_t start_bytes = serial_output_byte_count();
+	uint32_t start_time = get_current_time();
+	
+	uint8_t full_draw = !field_drawn;
+	
+	flush_deferred_cells();
+	initialise_walls();
+	if(field_drawn) {
+		restart_playable_cells();
+	} else {
+		initialise_pacdots();
+		draw_initial_game_field();
+	}
+	pacman_x = INIT_PACMAN_X;
+	pacman_y = INIT_PACMAN_Y;
+	pacman_direction = INIT_PACMAN_DIRN;
+	preturn_direction = NO_PRETURN;
+	draw_pacman_at(pacman_x, pacman_y);
+	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
+		ghost_cells[y] = 0;
+	}
+	for(int8_t i = 0; i < NUM_GHOSTS; i++) {
+		place_ghost(i, GHOST_HOME_X_LEFT + 2*i, GHOST_HOME_Y);
+		ghost_direction[i] = INIT_GHOST_DIRN;
+		ghost_edge[i] = NO_MAZE_EDGE;
+		draw_ghost_at(i, ghost_x[i], ghost_y[i]);
+	}
+	
+	draw_status_text(3);
+	
+	// Output is queued for the serial port, so wait until it has all been 
+	// sent - the time is then the time to get the level on to the screen
+	serial_flush();
+	if(full_draw) {
+		level_draw_bytes[wall_graphics_mode] = serial_output_byte_count() - start_bytes;
+		level_draw_ms[wall_graphics_mode] = get_current_time() - start_time;
+	} else {
+		level_restart_bytes = serial_output_byte_count() - start_bytes;
+		level_restart_ms = get_current_time() - start_time;
+	}
+	cell_deferral_enabled = 1;
+}
+
+void redraw_game_field(void) {
+	uint32_t start_bytes = serial_output_byte_count();
+	uint32_t start_time = get_current_time();
+	
+	flush_deferred_cells();
+	clear_terminal();
+	draw_walls();
+	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
+		for(uint8_t x = 0; x < FIELD_WIDTH; x++) {
+			if(!is_wall_at(x, y)) {
+				draw_cell(x, y);
+			}
+		}
+	}
+	draw_status_text(get_lives());
+	
+	serial_flush();
+	level_draw_bytes[wall_graphics_mode] = serial_output_byte_count() - start_bytes;
+	level_draw_ms[wall_graphics_mode] = get_current_time() - start_time;
+	cell_deferral_enabled = 1;
+}
+
 void initialise_game(void) {
 	initialise_game_level();
 	game_running = 1;
@@ -766,8 +1502,8 @@ void kill_ghost(uint8_t cell_contents) {
 	draw_pacman_at(ghost_x[cell_contents], ghost_y[cell_contents]);
 	
 	// Change the ghosts position to its home and redraw them there
-	ghost_x[cell_contents] = GHOST_HOME_X_LEFT + 2*cell_contents;
-	ghost_y[cell_contents] = GHOST_HOME_Y;
+	place_ghost(cell_contents, GHOST_HOME_X_LEFT + 2*cell_contents, GHOST_HOME_Y);
+	ghost_edge[cell_contents] = NO_MAZE_EDGE;
 	draw_power_pellet_ghost_at(cell_contents, ghost_x[cell_contents], ghost_y[cell_contents]);
 	pellet_ghosts[cell_contents] = 0;
 	
@@ -793,19 +1529,48 @@ void kill_ghost(uint8_t cell_contents) {
 	}
 	
 	// Play sound
-	set_prescalar(3);
+	play_sound(SOUND_GHOST_EATEN);
 }
 
 void reset_last_ghost_score(void) {
 	last_ghost_score = 0;
 }
 
+// Record the time (ms) from the input asking for a turn to it being made
+static void record_turn(uint16_t input_time) {
+	uint16_t latency = (uint16_t)get_current_time() - input_time;
+	if (turns_made < UINT16_MAX) {
+		turn_latency_total += latency;
+		turns_made++;
+	}
+	if (latency > turn_latency_max) {
+		turn_latency_max = latency;
+	}
+}
+
 int8_t move_pacman(void) {
 	if(!game_running) {
 		// Game is over - do nothing
 		return 0;
 	}
 	
+	// Make a remembered turn if it is now possible (or forget it if it
+	// has waited too long)
+	if (preturn_direction != NO_PRETURN) {
+		if (change_pacman_direction(preturn_direction)) {
+			record_turn(preturn_input_time);
+			if (preturns_made < UINT16_MAX) {
+				preturns_made++;
+			}
+			preturn_direction = NO_PRETURN;
+		} else if (--preturn_ticks_left == 0) {
+			if (preturns_expired < UINT16_MAX) {
+				preturns_expired++;
+			}
+			preturn_direction = NO_PRETURN;
+		}
+	}
+	
 	if (pacman_x == 0 && pacman_y == 15 && pacman_direction == DIRN_LEFT) {
 		erase_pixel_at(pacman_x, pacman_y);
 		pacman_x = 30;
@@ -843,16 +1608,16 @@ int8_t move_pacman(void) {
 		// Set the background colour to that of the ghost
 		// before we print out the pac-man
 		// Note that the variable cell_contents contains the ghost number
+		// Game is over (set first so the pac-man isn't deferred - the
+		// background colour has to be used straight away)
+		game_running = 0;
 		set_display_attribute(ghost_colours[cell_contents]);
 		draw_pacman_at(pacman_x, pacman_y);
-		// Game is over 
-		game_running = 0;
 	} else if (cell_contents >= 0 && power_pellet_eaten == 1) {
 		kill_ghost(cell_contents);
 	} else {
 		if(cell_contents == CELL_CONTAINS_PACDOT) {
 			eat_pacdot(10);
-			sound_enable_time = get_current_time();
 		} else if(cell_contents == CELL_CONTAINS_POWER_PELLET) {
 			eat_pacdot(50);
 			last_ghost_score = 0;
@@ -860,7 +1625,7 @@ int8_t move_pacman(void) {
 			power_pellet_eaten_time = get_current_time();
 			reset_dead_ghosts();
 			set_alive_pellet_ghosts();
-			set_prescalar(1);
+			play_sound(SOUND_POWER_PELLET);
 		}
 		draw_pacman_at(pacman_x, pacman_y);
 	}
@@ -872,11 +1637,13 @@ int8_t change_pacman_direction(int8_t direction) {
 		// Game is over - do nothing
 		return 0;
 	}
-	// Work out what is in the direction we want to move
-	int8_t cell_contents = what_is_in_dirn(pacman_x, pacman_y, direction);
-	if(cell_contents == CELL_IS_WALL) {
+	// Check whether there is a wall in the direction we want to move
+	if(!(cell_exits(pacman_x, pacman_y) & (1 << direction))) {
 		// Can't move
 		return 0;
+	} else if(direction == pacman_direction) {
+		// Already facing that way - nothing to redraw
+		return 1;
 	} else {
 		pacman_direction = direction;
 		// Redraw the pacman so it is facing in the right direction
@@ -885,14 +1652,33 @@ int8_t change_pacman_direction(int8_t direction) {
 	}
 }
 
+int8_t request_pacman_direction(int8_t direction, uint16_t input_time) {
+	uint8_t turning = (direction != pacman_direction);
+	if (change_pacman_direction(direction)) {
+		if (turning) {
+			record_turn(input_time);
+		}
+		preturn_direction = NO_PRETURN;
+		return 1;
+	}
+	if (game_running && PRETURN_EXPIRY_TICKS > 0) {
+		// Can't turn yet - remember it for move_pacman()
+		preturn_direction = direction;
+		preturn_ticks_left = PRETURN_EXPIRY_TICKS;
+		preturn_input_time = input_time;
+	}
+	return 0;
+}
+
 void play_again(void) {
 	
 	decrease_lives();
+	preturn_direction = NO_PRETURN;
 	
 	for (uint8_t i = 0; i < 4; i++) {
 		erase_pixel_at(ghost_x[i], ghost_y[i]);
-		ghost_x[i] = GHOST_HOME_X_LEFT + 2*i;
-		ghost_y[i] = GHOST_HOME_Y;
+		place_ghost(i, GHOST_HOME_X_LEFT + 2*i, GHOST_HOME_Y);
+		ghost_edge[i] = NO_MAZE_EDGE;
 		draw_ghost_at(i, ghost_x[i], ghost_y[i]);
 	}
 	
@@ -917,7 +1703,7 @@ void move_ghost(int8_t ghostnum) {
 		// Game is over - do nothing
 		return;
 	}
-	int8_t dirn_to_move = determine_ghost_direction_to_move(ghostnum);
+	int8_t dirn_to_move = next_ghost_direction(ghostnum);
 	if(dirn_to_move < 0) {
 		// Ghost can't move (e.g. boxed in) - do nothing
 		return;
@@ -929,20 +1715,23 @@ void move_ghost(int8_t ghostnum) {
 	// Update the ghost's direction (it's possible this may be the same value)
 	ghost_direction[ghostnum] = dirn_to_move;
 	// Update the ghost's location
+	uint8_t new_x = ghost_x[ghostnum];
+	uint8_t new_y = ghost_y[ghostnum];
 	switch(dirn_to_move) {
 		case DIRN_LEFT:
-			ghost_x[ghostnum]--;
+			new_x--;
 			break;
 		case DIRN_RIGHT:
-			ghost_x[ghostnum]++;
+			new_x++;
 			break;
 		case DIRN_UP:
-			ghost_y[ghostnum]--;
+			new_y--;
 			break;
 		case DIRN_DOWN:
-			ghost_y[ghostnum]++;
+			new_y++;
 			break;
 	}
+	place_ghost(ghostnum, new_x, new_y);
 	
 	// Check if the pac-man is at this ghost location. 
 	if (is_pacman_at(ghost_x[ghostnum], ghost_y[ghostnum]) && power_pellet_eaten == 0 && get_lives() - 1 > 0) {
@@ -998,10 +1787,6 @@ void set_alive_pellet_ghosts(void) {
 	alive_pellet_ghosts = 4;
 }
 
-uint32_t get_sound_time(void) {
-	return sound_enable_time;
-}
-
 uint16_t get_num_pacdots(void) {
 	return num_pacdots;
 }
@@ -1077,6 +1862,7 @@ uint8_t signature_check(void) {
 }
 
 void load_game_state(void) {
+	flush_deferred_cells();
 
 	// Lives
 	set_lives(load_lives[0]);
@@ -1100,7 +1886,6 @@ void load_game_state(void) {
 	uint8_t p;
 	uint8_t board_width;
 	uint8_t board_height;
-	uint32_t wall_array_index = 0;
 	num_pacdots = load_num_pacdots[0];
 	move_cursor(33, 1);
 	printf("%s", "Remaining number of pac-dots: ");
@@ -1117,37 +1902,14 @@ void load_game_state(void) {
 		}
 	}
 	
-	normal_display_mode();
-	hide_cursor();
-	move_cursor(1,1);
-	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
-		for(uint8_t x = 0; x < FIELD_WIDTH; x++) {
-			char wall_character = pgm_read_byte(&init_game_field[wall_array_index]);
-			switch(wall_character) {
-				case '-':	printf("%s", LINE_HORIZONTAL); break;
-				case '|':	printf("%s", LINE_VERTICAL); break;
-				case 'F':	printf("%s", LINE_DOWN_AND_RIGHT); break;
-				case '7':	printf("%s", LINE_DOWN_AND_LEFT); break;
-				case 'L':	printf("%s", LINE_UP_AND_RIGHT); break;
-				case 'J':	printf("%s", LINE_UP_AND_LEFT); break;
-				case '>':	printf("%s", LINE_VERTICAL_AND_RIGHT); break;
-				case '<':	printf("%s", LINE_VERTICAL_AND_LEFT); break;
-				case '^':	printf("%s", LINE_HORIZONTAL_AND_UP); break;
-				case 'v':	printf("%s", LINE_HORIZONTAL_AND_DOWN); break;
-				case '+':	printf("%s", LINE_VERTICAL_AND_HORIZONTAL); break;
-				case ' ':	printf(" "); break;
-				default:	move_cursor_right();
-			}
-			wall_array_index++;
-		}
-		printf("\n");
-	}
+	draw_walls();
 	
 	// Pacman
 	erase_pixel_at(pacman_x, pacman_y);
 	pacman_x = load_pacman_x[0];
 	pacman_y = load_pacman_y[0];
 	pacman_direction = load_pacman_dirn[0];
+	preturn_direction = NO_PRETURN;
 	draw_pacman_at(pacman_x, pacman_y);
 	
 	// Ghosts
@@ -1155,8 +1917,8 @@ void load_game_state(void) {
 	
 	for (g = 0; g < NUM_GHOSTS; g++) {
 		erase_pixel_at(ghost_x[g], ghost_y[g]);
-		ghost_x[g] = load_ghost_x[g];
-		ghost_y[g] = load_ghost_y[g];
+		place_ghost(g, load_ghost_x[g], load_ghost_y[g]);
+		ghost_edge[g] = NO_MAZE_EDGE;
 		
 		if (power_pellet_eaten) {
 			draw_power_pellet_ghost_at(g, ghost_x[g], ghost_y[g]);
@@ -1179,6 +1941,7 @@ void load_game_state(void) {
 		alive_pellet_ghosts = load_alive_pellet_ghosts[0];
 		power_pellet_eaten_time = load_eaten_pellet_time[0];
 	}
+	cell_deferral_enabled = 1;
 }
 
 void load_game(void) {
@@ -1217,44 +1980,202 @@ void load_game(void) {
 	load_game_state();
 }
 
+// row_window() returns the 16 bits of the given row bitboard that are
+// visible on the LED matrix when its left hand column is at origin_x
+// (bit 0 of the result is matrix column 0). Columns off the edge of the
+// game field are 0. The row is read a byte at a time so that the variable
+// shift is at most 7 bits.
+static uint16_t row_window(const uint32_t* row, int8_t origin_x) {
+	if (origin_x < 0) {
+		return (uint16_t)(*row << (uint8_t)(-origin_x));
+	}
+	const uint8_t* row_bytes = (const uint8_t*)row;
+	uint8_t byte_index = origin_x >> 3;
+	uint32_t bits = row_bytes[byte_index];
+	if (byte_index + 1 < sizeof(uint32_t)) {
+		bits |= (uint32_t)row_bytes[byte_index + 1] << 8;
+	}
+	if (byte_index + 2 < sizeof(uint32_t)) {
+		bits |= (uint32_t)row_bytes[byte_index + 2] << 16;
+	}
+	return (uint16_t)(bits >> (origin_x & 7));
+}
+
 void draw_ledmatrix_game(void) {
-	int8_t x;
-	int8_t y;
-	int8_t matrix_x = -1;
-	uint8_t matrix_y = 8;
-	uint8_t display_count = 0;
-	
-	for (x = pacman_x - 7; x < pacman_x + 9; x++) {
-		matrix_x++;
-		for (y = pacman_y - 4; y < pacman_y + 4; y++) {
-			matrix_y--;					
-			if (x < 0 || y < 0 || y > FIELD_HEIGHT - 1 || x > FIELD_WIDTH - 1) {
-				ledmatrix_update_pixel(matrix_x, matrix_y, COLOUR_BLACK);
-			} else if (what_is_at(x, y) == CELL_IS_WALL) {
-				ledmatrix_update_pixel(matrix_x, matrix_y, COLOUR_RED);
-			} else if (what_is_at(x, y) == CELL_CONTAINS_PACMAN) {
-				ledmatrix_update_pixel(matrix_x, matrix_y, COLOUR_YELLOW);
-			} else if (what_is_at(x, y) == CELL_CONTAINS_POWER_PELLET) {
-				ledmatrix_update_pixel(matrix_x, matrix_y, COLOUR_ORANGE);
-			} else if (what_is_at(x, y) == CELL_CONTAINS_PACDOT) {
-				ledmatrix_update_pixel(matrix_x, matrix_y, COLOUR_PALE_RED);
-			} else if (what_is_at(x, y) == CELL_IS_WALL) {
-				ledmatrix_update_pixel(matrix_x, matrix_y, COLOUR_RED);
-			} else if (what_is_at(x, y) >= 0) {
-				if (power_pellet_eaten == 0) {
-					ledmatrix_update_pixel(matrix_x, matrix_y, COLOUR_GREEN);
-				} else {
-					ledmatrix_update_pixel(matrix_x, matrix_y, COLOUR_PALE_GREEN);
-				}
-			} else if (what_is_at(x, y) == CELL_EMPTY) {
-				ledmatrix_update_pixel(matrix_x, matrix_y, COLOUR_BLACK);
-			}
-			display_count++;
-			if (display_count == 8) {
-				display_count = 0;
-				matrix_y = 8;
+	uint32_t start_cycles = get_current_cycles();
+	int8_t origin_x = pacman_x - 7;
+	int8_t origin_y = pacman_y - 4;
+	uint16_t wall_window[MATRIX_NUM_ROWS];
+	uint16_t dot_window[MATRIX_NUM_ROWS];
+	uint16_t pellet_window[MATRIX_NUM_ROWS];
+	uint16_t ghost_window[MATRIX_NUM_ROWS];
+	MatrixData frame;
+	
+	// If the view has moved by one cell since the last frame, scroll the
+	// display with a single shift command. Only the newly exposed edge
+	// (and anything that has moved) then differs from the frame below.
+	// Field rows increase downwards, LED matrix rows increase upwards.
+	if (origin_x == ledmatrix_origin_x + 1 && origin_y == ledmatrix_origin_y) {
+		ledmatrix_shift_display_left();
+	} else if (origin_x == ledmatrix_origin_x - 1 && origin_y == ledmatrix_origin_y) {
+		ledmatrix_shift_display_right();
+	} else if (origin_y == ledmatrix_origin_y + 1 && origin_x == ledmatrix_origin_x) {
+		ledmatrix_shift_display_up();
+	} else if (origin_y == ledmatrix_origin_y - 1 && origin_x == ledmatrix_origin_x) {
+		ledmatrix_shift_display_down();
+	}
+	ledmatrix_origin_x = origin_x;
+	ledmatrix_origin_y = origin_y;
+	
+	// Cut the 16 visible columns out of each of the row bitboards for the
+	// 8 visible rows. Matrix row 7 (top) shows field row origin_y.
+	for (uint8_t matrix_y = 0; matrix_y < MATRIX_NUM_ROWS; matrix_y++) {
+		int8_t y = origin_y + (MATRIX_NUM_ROWS - 1) - matrix_y;
+		if (y < 0 || y >= FIELD_HEIGHT) {
+			wall_window[matrix_y] = dot_window[matrix_y] = 0;
+			pellet_window[matrix_y] = ghost_window[matrix_y] = 0;
+			continue;
+		}
+		wall_window[matrix_y] = row_window(&walls[y], origin_x);
+		dot_window[matrix_y] = row_window(&pacdots[y], origin_x);
+		ghost_window[matrix_y] = row_window(&ghost_cells[y], origin_x);
+		pellet_window[matrix_y] = 0;
+		if (y == POWER_PELLET_ROW_1 || y == POWER_PELLET_ROW_2) {
+			uint32_t pellets = pacdots[y] & POWER_PELLET_COLUMNS;
+			pellet_window[matrix_y] = row_window(&pellets, origin_x);
+		}
+	}
+	
+	// Build each column of the display from the windows. Ghosts take 
+	// priority over pellets and dots, and pellets over dots. Dots and 
+	// walls never share a cell.
+	PixelColour ghost_colour = power_pellet_eaten ? COLOUR_PALE_GREEN : COLOUR_GREEN;
+	uint16_t column_bit = 1;
+	for (uint8_t matrix_x = 0; matrix_x < MATRIX_NUM_COLUMNS; matrix_x++) {
+		for (uint8_t matrix_y = 0; matrix_y < MATRIX_NUM_ROWS; matrix_y++) {
+			PixelColour colour = COLOUR_BLACK;
+			if (ghost_window[matrix_y] & column_bit) {
+				colour = ghost_colour;
+			} else if (pellet_window[matrix_y] & column_bit) {
+				colour = COLOUR_ORANGE;
+			} else if (dot_window[matrix_y] & column_bit) {
+				colour = COLOUR_PALE_RED;
+			} else if (wall_window[matrix_y] & column_bit) {
+				colour = COLOUR_RED;
 			}
+			frame[matrix_x][matrix_y] = colour;
 		}
+		column_bit <<= 1;
+	}
+	// The pac-man is always at the centre of the view
+	frame[7][MATRIX_NUM_ROWS - 1 - 4] = COLOUR_YELLOW;
+	
+	ledmatrix_render_cycles = get_current_cycles() - start_cycles;
+	ledmatrix_present(frame);
+}
+
+uint16_t get_ledmatrix_render_cycles(void) {
+	return ledmatrix_render_cycles;
+}
+
+uint8_t get_wall_graphics_mode(void) {
+	return wall_graphics_mode;
+}
+
+void toggle_wall_graphics_mode(void) {
+	if(wall_graphics_mode == WALLS_DEC_GRAPHICS) {
+		wall_graphics_mode = WALLS_UNICODE;
+	} else {
+		wall_graphics_mode = WALLS_DEC_GRAPHICS;
+	}
+	draw_walls();
+}
+
+uint32_t get_flow_field_cycles(void) {
+	return flow_field_cycles;
+}
+
+uint32_t get_flow_field_cycles_max(void) {
+	return flow_field_cycles_max;
+}
+
+void reset_flow_field_cycles_max(void) {
+	flow_field_cycles_max = 0;
+}
+
+void draw_deferred_cells(void) {
+	// Draw the oldest first, while there is room to do so without waiting
+	uint8_t drawn = 0;
+	cell_deferral_enabled = 0;
+	while(drawn < num_deferred_cells && serial_tx_space() >= CELL_UPDATE_SPACE) {
+		draw_cell(deferred_cell_x[drawn], deferred_cell_y[drawn]);
+		drawn++;
+	}
+	cell_deferral_enabled = 1;
+	num_deferred_cells -= drawn;
+	for(uint8_t i = 0; i < num_deferred_cells; i++) {
+		deferred_cell_x[i] = deferred_cell_x[i + drawn];
+		deferred_cell_y[i] = deferred_cell_y[i + drawn];
 	}
 }
 
+uint8_t deferred_cells_drawable(void) {
+	return num_deferred_cells > 0 && serial_tx_space() >= CELL_UPDATE_SPACE;
+}
+
+uint16_t get_cells_deferred(void) {
+	return cells_deferred;
+}
+
+uint16_t get_cells_coalesced(void) {
+	return cells_coalesced;
+}
+
+void reset_deferred_cell_counts(void) {
+	cells_deferred = 0;
+	cells_coalesced = 0;
+}
+
+uint16_t get_turns_made(void) {
+	return turns_made;
+}
+
+uint32_t get_turn_latency_total(void) {
+	return turn_latency_total;
+}
+
+uint16_t get_turn_latency_max(void) {
+	return turn_latency_max;
+}
+
+uint16_t get_preturns_made(void) {
+	return preturns_made;
+}
+
+uint16_t get_preturns_expired(void) {
+	return preturns_expired;
+}
+
+void reset_turn_counts(void) {
+	turns_made = 0;
+	turn_latency_total = 0;
+	turn_latency_max = 0;
+	preturns_made = 0;
+	preturns_expired = 0;
+}
+
+uint32_t get_level_draw_bytes(uint8_t mode) {
+	return level_draw_bytes[mode];
+}
+
+uint16_t get_level_draw_ms(uint8_t mode) {
+	return level_draw_ms[mode];
+}
+
+uint32_t get_level_restart_bytes(void) {
+	return level_restart_bytes;
+}
+
+uint16_t get_level_restart_ms(void) {
+	return level_restart_ms;
+}
@@ -17,6 +17,10 @@
 #define FIELD_HEIGHT 31
 #define FIELD_WIDTH 31
 
+// The performance statistics ('m') are shown to the right of the field, 
+// from terminal row 20 down to this row - below the bottom of the field
+#define PERFORMANCE_STATS_LAST_ROW 38
+
 // Number of ghosts in the game
 #define NUM_GHOSTS 4
 
@@ -35,7 +39,9 @@ void initialise_game(void);
 // Initialise the game level - re-outputs the game field
 // and restores all positions to their original values. This 
 // function is called by initialise_game() above and only 
-// needs to be called again if a new level is started.
+// needs to be called again if a new level is started. The whole
+// field is only output the first time - after that only the cells
+// that have changed are redrawn.
 void initialise_game_level(void);
 
 // Attempt to move the pacman in its current direction. Returns 1 if successful, 
@@ -50,6 +56,22 @@ int8_t move_pacman(void);
 // Nothing happens if the game is over (0 is returned.)
 int8_t change_pacman_direction(int8_t direction);
 
+// Number of pac-man move ticks a turn that couldn't be made straight away
+// is remembered for (see request_pacman_direction() below). 0 turns off 
+// pre-turning.
+#ifndef PRETURN_EXPIRY_TICKS
+#define PRETURN_EXPIRY_TICKS 3
+#endif
+
+// As change_pacman_direction() but if the pac-man can't turn yet the 
+// direction is remembered and the turn is made by move_pacman() on the 
+// first tick that it can be (if that is within PRETURN_EXPIRY_TICKS ticks).
+// A turn that can be made straight away forgets any remembered direction.
+// input_time is when the input asking for the turn happened (low 16 bits
+// of get_current_time()) - used to measure the latency until the turn.
+// Returns 1 if the pac-man turned (or already faced that way), 0 if not.
+int8_t request_pacman_direction(int8_t direction, uint16_t input_time);
+
 // Attempt to move a ghost (ghostnum is 0 to NUM_GHOSTS - 1).
 // The direction is chosen based on the location of the ghost
 // and the location of the pacman and which ghost this is.
@@ -70,12 +92,62 @@ uint32_t get_power_pellet_time(void);
 uint8_t get_dead_ghost(uint8_t value);
 void reset_dead_ghosts(void);
 void set_alive_pellet_ghosts(void);
-uint32_t get_sound_time(void);
 void play_again(void);
 uint16_t get_num_pacdots(void);
 void save_game(void);
 void load_game(void);
 void draw_ledmatrix_game(void);
+uint16_t get_ledmatrix_render_cycles(void);
+
+// Ways of drawing the walls on the terminal - as UTF-8 box drawing 
+// characters (3 bytes each) or with the VT100 DEC Special Graphics 
+// character set (1 byte each)
+#define WALLS_UNICODE 0
+#define WALLS_DEC_GRAPHICS 1
+uint8_t get_wall_graphics_mode(void);
+// Switch to the other wall drawing mode and redraw the walls
+void toggle_wall_graphics_mode(void);
+// CPU cycles taken by the last update of the ghosts' flow field (the 
+// distances to the pac-man) and the most taken by an update since the 
+// last call to reset_flow_field_cycles_max()
+uint32_t get_flow_field_cycles(void);
+uint32_t get_flow_field_cycles_max(void);
+void reset_flow_field_cycles_max(void);
+// Redraw the whole game field (and the text beside it) as it is now - 
+// e.g. after the terminal has been cleared or its baud rate changed
+void redraw_game_field(void);
+// Serial bytes output and milliseconds taken (until the last byte was
+// sent) by the last full draw of the game field - the first call to 
+// initialise_game_level() or a call to redraw_game_field() - with the
+// walls drawn in the given mode (WALLS_UNICODE or WALLS_DEC_GRAPHICS) - 0
+// if there hasn't been one
+uint32_t get_level_draw_bytes(uint8_t mode);
+uint16_t get_level_draw_ms(uint8_t mode);
+// The same for the last level restart (a later call to 
+// initialise_game_level() - only the cells that changed are redrawn)
+uint32_t get_level_restart_bytes(void);
+uint16_t get_level_restart_ms(void);
+// Cell updates are deferred (rather than waiting for room in the serial
+// output buffer) when the serial link can't keep up. draw_deferred_cells()
+// draws as many of the deferred cells as there is room for, as they are 
+// now. deferred_cells_drawable() returns 1 if there are deferred cells 
+// and room to draw at least one. The counts are of updates deferred and 
+// of updates to cells that were already waiting (so were coalesced).
+void draw_deferred_cells(void);
+uint8_t deferred_cells_drawable(void);
+uint16_t get_cells_deferred(void);
+uint16_t get_cells_coalesced(void);
+void reset_deferred_cell_counts(void);
+// Turns made by request_pacman_direction() - the number made, the total
+// and worst time (ms) from the input to the turn, how many of them were
+// remembered turns made later by move_pacman() and how many remembered 
+// turns expired without being made
+uint16_t get_turns_made(void);
+uint32_t get_turn_latency_total(void);
+uint16_t get_turn_latency_max(void);
+uint16_t get_preturns_made(void);
+uint16_t get_preturns_expired(void);
+void reset_turn_counts(void);
 void change_game_paused(void);
 uint8_t game_paused_status(void);
 uint8_t signature_check(void);
@@ -0,0 +1,20 @@
+/*
+ * avr/eeprom.h - host stand-in
+ *
+ * The EEPROM is an array in led_benchmark.c. Addresses are offsets 
+ * into it, as they are on the AVR.
+ */
+
+#ifndef HOST_EEPROM_H_
+#define HOST_EEPROM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <avr/io.h>
+
+#define EEMEM
+
+void eeprom_read_block(void* destination, const void* source, size_t size);
+void eeprom_update_block(const void* source, void* destination, size_t size);
+
+#endif /* HOST_EEPROM_H_ */
@@ -0,0 +1,18 @@
+/*
+ * avr/io.h - host stand-in
+ *
+ * Only the registers and bits game.c touches (the power pellet LEDs on
+ * port A) are provided.
+ */
+
+#ifndef HOST_IO_H_
+#define HOST_IO_H_
+
+#include <stdint.h>
+
+extern volatile uint8_t PORTA;
+#define PORTA5 5
+#define PORTA6 6
+#define PORTA7 7
+
+#endif /* HOST_IO_H_ */
@@ -0,0 +1,30 @@
+/*
+ * avr/pgmspace.h - host stand-in
+ *
+ * Program memory is ordinary memory on the host, so PROGMEM is dropped
+ * and the pgm_read_*() functions become plain reads.
+ */
+
+#ifndef HOST_PGMSPACE_H_
+#define HOST_PGMSPACE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+typedef const char* PGM_P;
+
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define pgm_read_ptr(address) (*(void* const*)(address))
+
+#define printf_P printf
+#define fputs_P fputs
+#define puts_P puts
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+#endif /* HOST_PGMSPACE_H_ */
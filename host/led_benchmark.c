@@ -0,0 +1,292 @@
+/*
+ * led_benchmark.c
+ *
+ * Host (PC) check of draw_ledmatrix_game(). It plays simulated games
+ * and, after every move, renders the LED matrix view twice: once with
+ * draw_ledmatrix_game() (rows cut out of the bitboards) and once with
+ * a copy of the original renderer, which classified every cell with the
+ * original what_is_at() (a loop over the ghosts and a read of the maze
+ * from flash for each cell). The two frames must match pixel for pixel.
+ * The time each renderer takes is also reported - these are host times,
+ * so only the ratio between them means anything, not the AVR cycle
+ * count.
+ *
+ * Build and run from the top level of the repository with
+ *     gcc -std=gnu99 -O2 -Ihost -o led_benchmark host/led_benchmark.c \
+ *         terminalio.c score.c lives.c
+ *     ./led_benchmark
+ * It returns non-zero if any frame differs.
+ *
+ * The AVR headers are replaced by the stand-ins in host/avr. The rest
+ * of the board (serial port, timer, buzzer, LED matrix) is stubbed out
+ * below. game.c is included rather than linked so that the game state
+ * (pac-man, ghosts, pac-dots) can be read by the original renderer.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../game.c"
+
+#define NUM_GAMES 30
+#define MOVES_PER_GAME 3000
+
+///////////////////////////////////////////////////////////
+// Stubs for the rest of the board
+volatile uint8_t PORTA;
+
+static uint8_t eeprom[1024];
+static uint32_t fake_time;
+
+void eeprom_read_block(void* destination, const void* source, size_t size) {
+	memcpy(destination, eeprom + (size_t)source, size);
+}
+
+void eeprom_update_block(const void* source, void* destination, size_t size) {
+	memcpy(eeprom + (size_t)destination, source, size);
+}
+
+uint32_t get_current_time(void) {
+	return fake_time;
+}
+
+uint32_t get_current_cycles(void) {
+	return fake_time * 8000;
+}
+
+uint32_t get_paused_time(void) {
+	return 0;
+}
+
+void set_time(uint32_t value) {
+	fake_time = value;
+}
+
+void play_sound(uint8_t sound) {
+}
+
+void serial_write(const char* data, uint16_t length) {
+}
+
+uint16_t serial_tx_space(void) {
+	return SERIAL_TX_BUFFER_SIZE - 1;
+}
+
+void serial_flush(void) {
+}
+
+uint32_t serial_output_byte_count(void) {
+	return 0;
+}
+
+// The last frame handed to the LED matrix
+static MatrixData presented;
+
+void ledmatrix_present(MatrixData frame) {
+	memcpy(presented, frame, sizeof(MatrixData));
+}
+
+void ledmatrix_shift_display_left(void) {
+}
+
+void ledmatrix_shift_display_right(void) {
+}
+
+void ledmatrix_shift_display_up(void) {
+}
+
+void ledmatrix_shift_display_down(void) {
+}
+
+///////////////////////////////////////////////////////////
+// The original cell classification, as it was before the bitboards
+
+static int8_t original_is_wall_at(uint8_t x, uint8_t y) {
+	char wall_character = pgm_read_byte(&init_game_field[y * FIELD_WIDTH + x]);
+	return (wall_character != ' ' && wall_character != '.'
+			&& wall_character != 'P');
+}
+
+static int8_t original_is_pacman_at(uint8_t x, uint8_t y) {
+	return (x == pacman_x && y == pacman_y);
+}
+
+static int8_t original_is_pacdot_at(uint8_t x, uint8_t y) {
+	uint32_t dots_on_row = pacdots[y];
+	if(dots_on_row & (1UL << x)) {
+		return 1;
+	} else {
+		return 0;
+	}
+}
+
+static int8_t original_is_power_pellet_at(uint8_t x, uint8_t y) {
+	if ((y == 6 || y == 23) && (x == 1 || x == 29)) {
+		uint32_t dots_on_row = pacdots[y];
+
+		if(dots_on_row & (1UL << x)) {
+			return 1;
+		} else {
+			return 0;
+		}
+	}
+	return 0;
+}
+
+static int8_t original_is_ghost_home(uint8_t x, uint8_t y) {
+	if(y == GHOST_HOME_Y && x >= GHOST_HOME_X_LEFT && x <= GHOST_HOME_X_RIGHT) {
+		return 1;
+	} else if(y == GHOST_HOME_ENTRY_Y && x >= GHOST_HOME_ENTRY_X_LEFT
+			&& x <= GHOST_HOME_ENTRY_X_RIGHT) {
+		return 1;
+	} else {
+		return 0;
+	}
+}
+
+static int8_t original_what_is_at(uint8_t x, uint8_t y) {
+	if(original_is_pacman_at(x,y)) {
+		return CELL_CONTAINS_PACMAN;
+	} else {
+		for(int8_t i = 0; i < NUM_GHOSTS; i++) {
+			if(x == ghost_x[i] && y == ghost_y[i]) {
+				return i;	// ghost number
+			}
+		}
+	}
+	if (original_is_power_pellet_at(x, y)) {
+		return CELL_CONTAINS_POWER_PELLET;
+	} else if (original_is_pacdot_at(x,y)) {
+		return CELL_CONTAINS_PACDOT;
+	} else if (original_is_wall_at(x,y)) {
+		return CELL_IS_WALL;
+	} else if(original_is_ghost_home(x,y)) {
+		return CELL_IS_GHOST_HOME;
+	}
+	return CELL_EMPTY;
+}
+
+///////////////////////////////////////////////////////////
+// The original draw_ledmatrix_game(), drawing into a frame instead of
+// the LED matrix. It left the ghost home cells as they were - those
+// pixels are not drawn and not compared.
+static MatrixData expected;
+static MatrixData drawn;
+
+static void original_update_pixel(uint8_t x, uint8_t y, PixelColour colour) {
+	expected[x][y] = colour;
+	drawn[x][y] = 1;
+}
+
+static void original_draw_ledmatrix_game(void) {
+	int8_t x;
+	int8_t y;
+	int8_t matrix_x = -1;
+	uint8_t matrix_y = 8;
+	uint8_t display_count = 0;
+
+	memset(drawn, 0, sizeof(MatrixData));
+	for (x = pacman_x - 7; x < pacman_x + 9; x++) {
+		matrix_x++;
+		for (y = pacman_y - 4; y < pacman_y + 4; y++) {
+			matrix_y--;
+			if (x < 0 || y < 0 || y > FIELD_HEIGHT - 1 || x > FIELD_WIDTH - 1) {
+				original_update_pixel(matrix_x, matrix_y, COLOUR_BLACK);
+			} else if (original_what_is_at(x, y) == CELL_IS_WALL) {
+				original_update_pixel(matrix_x, matrix_y, COLOUR_RED);
+			} else if (original_what_is_at(x, y) == CELL_CONTAINS_PACMAN) {
+				original_update_pixel(matrix_x, matrix_y, COLOUR_YELLOW);
+			} else if (original_what_is_at(x, y) == CELL_CONTAINS_POWER_PELLET) {
+				original_update_pixel(matrix_x, matrix_y, COLOUR_ORANGE);
+			} else if (original_what_is_at(x, y) == CELL_CONTAINS_PACDOT) {
+				original_update_pixel(matrix_x, matrix_y, COLOUR_PALE_RED);
+			} else if (original_what_is_at(x, y) == CELL_IS_WALL) {
+				original_update_pixel(matrix_x, matrix_y, COLOUR_RED);
+			} else if (original_what_is_at(x, y) >= 0) {
+				if (power_pellet_eaten == 0) {
+					original_update_pixel(matrix_x, matrix_y, COLOUR_GREEN);
+				} else {
+					original_update_pixel(matrix_x, matrix_y, COLOUR_PALE_GREEN);
+				}
+			} else if (original_what_is_at(x, y) == CELL_EMPTY) {
+				original_update_pixel(matrix_x, matrix_y, COLOUR_BLACK);
+			}
+			display_count++;
+			if (display_count == 8) {
+				display_count = 0;
+				matrix_y = 8;
+			}
+		}
+	}
+}
+
+// frames_match() returns 1 if the presented frame matches the original
+// renderer's frame in every pixel that renderer drew
+static uint8_t frames_match(void) {
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			if(drawn[x][y] && presented[x][y] != expected[x][y]) {
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+static uint64_t nanoseconds(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+int main(void) {
+	uint32_t frames = 0;
+	uint32_t mismatches = 0;
+	uint64_t new_time = 0;
+	uint64_t old_time = 0;
+	uint64_t start;
+
+	// The game prints to the terminal as it goes - throw that away
+	if (freopen("/dev/null", "w", stdout) == NULL) {
+		return 2;
+	}
+
+	for (uint8_t game = 0; game < NUM_GAMES; game++) {
+		srandom(game);
+		init_lives();
+		initialise_game();
+		// Every other game is played with the ghosts frightened
+		if (game % 2) {
+			power_pellet_eaten = 1;
+		}
+		for (uint16_t move = 0; move < MOVES_PER_GAME && !is_game_over(); move++) {
+			fake_time++;
+			move_ghost(move % NUM_GHOSTS);
+			if (move % 3 == 0) {
+				change_pacman_direction(random() % 4);
+				move_pacman();
+			}
+
+			start = nanoseconds();
+			draw_ledmatrix_game();
+			new_time += nanoseconds() - start;
+
+			start = nanoseconds();
+			original_draw_ledmatrix_game();
+			old_time += nanoseconds() - start;
+
+			if (!frames_match()) {
+				mismatches++;
+			}
+			frames++;
+		}
+	}
+
+	fprintf(stderr, "%lu frames, %lu differ from the original renderer\n",
+			(unsigned long)frames, (unsigned long)mismatches);
+	fprintf(stderr, "host time per frame: bitboards %.0f ns, original %.0f ns\n",
+			(double)new_time / frames, (double)old_time / frames);
+	return mismatches != 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * maze_graph.c
+ *
+ * Host (PC) program that works out the junction graph of the maze in
+ * maze.h and writes it out as maze_graph.h. Run it again whenever the
+ * maze or the ghost home changes. From the top level of the repository:
+ *     gcc -std=gnu99 -O2 -I. -o maze_graph host/maze_graph.c
+ *     ./maze_graph > maze_graph.h
+ *
+ * The graph is the maze as the ghosts see it: the cells they can reach
+ * once they have left the ghost home, which they can't go back into.
+ * Nodes are the junctions (cells with three or four open neighbours),
+ * the dead ends (one open neighbour) and the ends of the tunnel. Every
+ * other cell is part of a corridor (an edge) joining two nodes. For each
+ * edge the length (number of moves) and the direction of each move along
+ * it are recorded. The tunnel, which joins the two sides of the field,
+ * is a link of length 1 between its ends.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "game.h"
+#include "maze.h"
+
+#define NO_NODE 0xFF
+#define MAX_NODES 254
+#define MAX_EDGES 254
+#define MAX_PATH_STEPS (FIELD_WIDTH * FIELD_HEIGHT * 4)
+
+static const char* const maze[FIELD_HEIGHT] = {
+	MAZE_ROW_0, MAZE_ROW_1, MAZE_ROW_2, MAZE_ROW_3, MAZE_ROW_4,
+	MAZE_ROW_5, MAZE_ROW_6, MAZE_ROW_7, MAZE_ROW_8, MAZE_ROW_9,
+	MAZE_ROW_10, MAZE_ROW_11, MAZE_ROW_12, MAZE_ROW_13, MAZE_ROW_14,
+	MAZE_ROW_15, MAZE_ROW_16, MAZE_ROW_17, MAZE_ROW_18, MAZE_ROW_19,
+	MAZE_ROW_20, MAZE_ROW_21, MAZE_ROW_22, MAZE_ROW_23, MAZE_ROW_24,
+	MAZE_ROW_25, MAZE_ROW_26, MAZE_ROW_27, MAZE_ROW_28, MAZE_ROW_29,
+	MAZE_ROW_30
+};
+
+static const char* const dirn_names[4] = { "left", "up", "right", "down" };
+static const int8_t delta_x[4] = { -1, 0, 1, 0 };
+static const int8_t delta_y[4] = { 0, -1, 0, 1 };
+
+static uint8_t reachable[FIELD_HEIGHT][FIELD_WIDTH];
+static uint8_t node_at[FIELD_HEIGHT][FIELD_WIDTH];
+static uint8_t node_x[MAX_NODES];
+static uint8_t node_y[MAX_NODES];
+static uint8_t node_edges[MAX_NODES][4];
+static uint8_t num_nodes;
+
+static uint16_t edge_path[MAX_EDGES];
+static uint8_t edge_length[MAX_EDGES];
+static uint8_t edge_from[MAX_EDGES];
+static uint8_t edge_to[MAX_EDGES];
+static uint8_t edge_dirn[MAX_EDGES];
+static uint8_t num_edges;
+
+static uint8_t path_steps[MAX_PATH_STEPS];
+static uint16_t num_path_steps;
+
+static void fail(const char* message) {
+	fprintf(stderr, "maze_graph: %s\n", message);
+	exit(1);
+}
+
+static int is_ghost_home(int x, int y) {
+	return (y == GHOST_HOME_Y && x >= GHOST_HOME_X_LEFT && x <= GHOST_HOME_X_RIGHT) ||
+			(y == GHOST_HOME_ENTRY_Y && x >= GHOST_HOME_ENTRY_X_LEFT
+			&& x <= GHOST_HOME_ENTRY_X_RIGHT);
+}
+
+// A cell is open if a ghost outside the home can be there
+static int is_open(int x, int y) {
+	if (x < 0 || y < 0 || x >= FIELD_WIDTH || y >= FIELD_HEIGHT || is_ghost_home(x, y)) {
+		return 0;
+	}
+	char c = maze[y][x];
+	return c == ' ' || c == '.' || c == 'P';
+}
+
+static int is_tunnel_end(int x, int y) {
+	return (x == 0 || x == FIELD_WIDTH - 1) && is_open(0, y) && is_open(FIELD_WIDTH - 1, y);
+}
+
+static int exits_from(int x, int y) {
+	int exits = 0;
+	for (int dirn = 0; dirn < 4; dirn++) {
+		if (is_open(x + delta_x[dirn], y + delta_y[dirn])) {
+			exits |= 1 << dirn;
+		}
+	}
+	return exits;
+}
+
+static int count_bits(int value) {
+	int count = 0;
+	for (; value; value &= value - 1) {
+		count++;
+	}
+	return count;
+}
+
+// Mark the cells a ghost can reach from (x,y), following the tunnel too
+static void mark_reachable(int x, int y) {
+	if (!is_open(x, y) || reachable[y][x]) {
+		return;
+	}
+	reachable[y][x] = 1;
+	for (int dirn = 0; dirn < 4; dirn++) {
+		mark_reachable(x + delta_x[dirn], y + delta_y[dirn]);
+	}
+	if (is_tunnel_end(x, y)) {
+		mark_reachable(FIELD_WIDTH - 1 - x, y);
+	}
+}
+
+static void add_edge(uint8_t from, uint8_t dirn, uint8_t to, uint16_t path, uint16_t length) {
+	if (num_edges == MAX_EDGES) {
+		fail("too many edges");
+	}
+	if (length > 255) {
+		fail("corridor too long");
+	}
+	edge_from[num_edges] = from;
+	edge_dirn[num_edges] = dirn;
+	edge_to[num_edges] = to;
+	edge_path[num_edges] = path;
+	edge_length[num_edges] = length;
+	node_edges[from][dirn] = num_edges;
+	num_edges++;
+}
+
+// Follow the corridor leaving the given node in direction first_dirn to
+// the node at the other end and add it as an edge
+static void follow_corridor(uint8_t node, uint8_t first_dirn) {
+	int x = node_x[node];
+	int y = node_y[node];
+	int dirn = first_dirn;
+	uint16_t path = num_path_steps;
+	uint16_t length = 0;
+	for (;;) {
+		if (num_path_steps == MAX_PATH_STEPS) {
+			fail("corridor without a node at the end");
+		}
+		path_steps[num_path_steps++] = dirn;
+		length++;
+		x += delta_x[dirn];
+		y += delta_y[dirn];
+		if (node_at[y][x] != NO_NODE) {
+			break;
+		}
+		// A corridor cell - exactly one way on besides back
+		int ways_on = exits_from(x, y) & ~(1 << ((dirn + 2) % 4));
+		for (dirn = 0; !(ways_on & (1 << dirn)); dirn++) {
+		}
+	}
+	add_edge(node, first_dirn, node_at[y][x], path, length);
+}
+
+static void find_nodes(void) {
+	// Nodes are numbered along each row in turn
+	for (int y = 0; y < FIELD_HEIGHT; y++) {
+		for (int x = 0; x < FIELD_WIDTH; x++) {
+			node_at[y][x] = NO_NODE;
+			if (reachable[y][x] && (count_bits(exits_from(x, y)) != 2 || is_tunnel_end(x, y))) {
+				if (num_nodes == MAX_NODES) {
+					fail("too many nodes");
+				}
+				node_x[num_nodes] = x;
+				node_y[num_nodes] = y;
+				node_at[y][x] = num_nodes++;
+			}
+		}
+	}
+}
+
+static void find_edges(void) {
+	for (uint8_t node = 0; node < num_nodes; node++) {
+		int x = node_x[node];
+		int y = node_y[node];
+		int exits = exits_from(x, y);
+		for (uint8_t dirn = 0; dirn < 4; dirn++) {
+			node_edges[node][dirn] = NO_NODE;
+			if (exits & (1 << dirn)) {
+				follow_corridor(node, dirn);
+			} else if (is_tunnel_end(x, y) && x + delta_x[dirn] == (x ? FIELD_WIDTH : -1)) {
+				// Out through the tunnel to the other side of the field
+				path_steps[num_path_steps] = dirn;
+				add_edge(node, dirn, node_at[y][FIELD_WIDTH - 1 - x], num_path_steps++, 1);
+			}
+		}
+	}
+}
+
+static void print_graph(void) {
+	printf("/*\n");
+	printf(" * maze_graph.h\n");
+	printf(" *\n");
+	printf(" * Junction graph of the maze in maze.h for the ghosts - written by\n");
+	printf(" * host/maze_graph.c (see there for how to run it). Don't edit this file,\n");
+	printf(" * run that again if the maze changes.\n");
+	printf(" *\n");
+	printf(" * Nodes are the junctions, dead ends and tunnel ends the ghosts can reach\n");
+	printf(" * (not the ghost home), numbered along each row in turn. Edges are the\n");
+	printf(" * corridors joining them.\n");
+	printf(" * - maze_node_cells[y] has bit x set if there is a node at (x,y) and\n");
+	printf(" *   maze_node_row_first[y] is the number of the first node on row y.\n");
+	printf(" * - maze_node_edges[node][dirn] is the edge leaving the node in direction\n");
+	printf(" *   dirn (DIRN_LEFT etc.) or NO_MAZE_EDGE.\n");
+	printf(" * - maze_edges[edge] gives the node at the other end, the number of moves\n");
+	printf(" *   along the edge and where the directions of those moves start in\n");
+	printf(" *   maze_edge_paths[]. That holds 2 bits per move, 4 moves to a byte with\n");
+	printf(" *   the first in the low bits.\n");
+	printf(" * The tunnel is an edge of length 1 between its two ends.\n");
+	printf(" */\n\n");
+	printf("#ifndef MAZE_GRAPH_H_\n#define MAZE_GRAPH_H_\n\n");
+	printf("#include <stdint.h>\n#include <avr/pgmspace.h>\n#include \"game.h\"\n\n");
+	printf("#define MAZE_NUM_NODES %u\n", num_nodes);
+	printf("#define MAZE_NUM_EDGES %u\n", num_edges);
+	printf("#define NO_MAZE_NODE 0xFF\n");
+	printf("#define NO_MAZE_EDGE 0xFF\n\n");
+	printf("typedef struct {\n\tuint16_t path;\n\tuint8_t length;\n\tuint8_t to;\n} MazeEdge;\n\n");
+
+	printf("static const uint32_t maze_node_cells[FIELD_HEIGHT] PROGMEM = {\n");
+	for (int y = 0; y < FIELD_HEIGHT; y++) {
+		uint32_t cells = 0;
+		for (int x = 0; x < FIELD_WIDTH; x++) {
+			if (node_at[y][x] != NO_NODE) {
+				cells |= 1UL << x;
+			}
+		}
+		printf("\t0x%08lX%s\t// row %d\n", (unsigned long)cells, y < FIELD_HEIGHT - 1 ? "," : "", y);
+	}
+	printf("};\n\n");
+
+	printf("static const uint8_t maze_node_row_first[FIELD_HEIGHT] PROGMEM = {");
+	uint8_t first = 0;
+	for (int y = 0; y < FIELD_HEIGHT; y++) {
+		printf("%s%u%s", y % 10 ? " " : "\n\t", first, y < FIELD_HEIGHT - 1 ? "," : "\n");
+		for (int x = 0; x < FIELD_WIDTH; x++) {
+			first += node_at[y][x] != NO_NODE;
+		}
+	}
+	printf("};\n\n");
+
+	printf("static const uint8_t maze_node_edges[MAZE_NUM_NODES][4] PROGMEM = {\n");
+	for (int node = 0; node < num_nodes; node++) {
+		printf("\t{");
+		for (int dirn = 0; dirn < 4; dirn++) {
+			if (node_edges[node][dirn] == NO_NODE) {
+				printf("NO_MAZE_EDGE");
+			} else {
+				printf("%u", node_edges[node][dirn]);
+			}
+			printf("%s", dirn < 3 ? ", " : "}");
+		}
+		printf("%s\t// %d: (%d,%d)\n", node < num_nodes - 1 ? "," : "", node, node_x[node], node_y[node]);
+	}
+	printf("};\n\n");
+
+	printf("static const MazeEdge maze_edges[MAZE_NUM_EDGES] PROGMEM = {\n");
+	for (int edge = 0; edge < num_edges; edge++) {
+		uint8_t from = edge_from[edge];
+		uint8_t to = edge_to[edge];
+		printf("\t{%u, %u, %u}%s\t// %d: (%d,%d) %s to (%d,%d)%s\n", edge_path[edge],
+				edge_length[edge], to, edge < num_edges - 1 ? "," : "", edge,
+				node_x[from], node_y[from], dirn_names[edge_dirn[edge]], node_x[to], node_y[to],
+				is_tunnel_end(node_x[from], node_y[from]) && edge_length[edge] == 1 &&
+				!(exits_from(node_x[from], node_y[from]) & (1 << edge_dirn[edge])) ? " - tunnel" : "");
+	}
+	printf("};\n\n");
+
+	printf("static const uint8_t maze_edge_paths[%u] PROGMEM = {", (num_path_steps + 3) / 4);
+	for (uint16_t i = 0; i < num_path_steps; i += 4) {
+		uint8_t bits = 0;
+		for (uint16_t step = i; step < i + 4 && step < num_path_steps; step++) {
+			bits |= path_steps[step] << ((step - i) * 2);
+		}
+		printf("%s0x%02X%s", (i / 4) % 12 ? " " : "\n\t", bits, i + 4 < num_path_steps ? "," : "\n");
+	}
+	printf("};\n\n");
+	printf("#endif /* MAZE_GRAPH_H_ */\n");
+}
+
+int main(void) {
+	// The ghosts leave their home through the cells above its entry
+	mark_reachable(GHOST_HOME_ENTRY_X_LEFT, GHOST_HOME_ENTRY_Y - 1);
+	find_nodes();
+	find_edges();
+	print_graph();
+	return 0;
+}
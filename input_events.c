@@ -0,0 +1,60 @@
+/*
+ * input_events.c
+ *
+ * The queue only has one reader (the main loop) and its writers are
+ * interrupt handlers, which can't interrupt each other. The head is only
+ * changed by the writers and the tail only by the reader, and each is a
+ * single byte (so is read and written in one go), so neither side needs
+ * to turn interrupts off. The positions run freely and are masked when
+ * used, so head - tail is the number of events waiting.
+ */
+
+#include "input_events.h"
+#include "timer0.h"
+
+#define INPUT_EVENT_QUEUE_MASK (INPUT_EVENT_QUEUE_SIZE - 1)
+static volatile InputEvent event_queue[INPUT_EVENT_QUEUE_SIZE];
+static volatile uint8_t event_queue_head;
+static volatile uint8_t event_queue_tail;
+
+static uint8_t events_dropped;
+
+void add_input_event(uint8_t type, uint8_t value) {
+	uint8_t head = event_queue_head;
+	if((uint8_t)(head - event_queue_tail) >= INPUT_EVENT_QUEUE_SIZE) {
+		// Queue is full
+		if(events_dropped < UINT8_MAX) {
+			events_dropped++;
+		}
+		return;
+	}
+	volatile InputEvent* event = &event_queue[head & INPUT_EVENT_QUEUE_MASK];
+	event->type = type;
+	event->value = value;
+	event->time = (uint16_t)get_current_time();
+	// Only make the event visible once it is complete
+	event_queue_head = head + 1;
+}
+
+uint8_t input_events_waiting(void) {
+	return event_queue_head != event_queue_tail;
+}
+
+uint8_t get_input_event(InputEvent* event) {
+	uint8_t tail = event_queue_tail;
+	if(tail == event_queue_head) {
+		return 0;
+	}
+	*event = event_queue[tail & INPUT_EVENT_QUEUE_MASK];
+	// Only free the slot once the event has been copied
+	event_queue_tail = tail + 1;
+	return 1;
+}
+
+void clear_input_events(void) {
+	event_queue_tail = event_queue_head;
+}
+
+uint8_t input_events_dropped(void) {
+	return events_dropped;
+}
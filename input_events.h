@@ -0,0 +1,66 @@
+/*
+ * input_events.h
+ *
+ * A single queue of input events - button pushes, serial characters and
+ * cursor keys, and joystick direction changes. Events are added by the
+ * interrupt handlers that detect them (buttons.c, serialio.c and
+ * joystick.c) and read by the main loop in the order they happened. Each
+ * event carries the time (see get_current_time()) it was detected.
+ */
+
+#ifndef INPUT_EVENTS_H_
+#define INPUT_EVENTS_H_
+
+#include <stdint.h>
+
+// Event types. The meaning of the event value depends on the type.
+#define INPUT_BUTTON 0		// Button pushed - value is the button (0 to 3)
+#define INPUT_KEY 1			// Character received - value is the character
+#define INPUT_ARROW 2		// Cursor key - value is one of ARROW_UP etc. below
+#define INPUT_JOYSTICK 3	// Joystick moved - value is the new direction
+							// (CENTRE to NORTH_WEST - see joystick.h)
+
+// Cursor keys - the last character of their escape sequences (ESC [ A etc.)
+#define ARROW_UP 'A'
+#define ARROW_DOWN 'B'
+#define ARROW_RIGHT 'C'
+#define ARROW_LEFT 'D'
+
+// Size of the queue (events). Must be a power of 2, no larger than 128.
+#ifndef INPUT_EVENT_QUEUE_SIZE
+#define INPUT_EVENT_QUEUE_SIZE 16
+#endif
+
+typedef struct {
+	uint8_t type;
+	uint8_t value;
+	uint16_t time;	// Low 16 bits of get_current_time() when it happened
+} InputEvent;
+
+/* Add an event to the queue, timestamped with the current time. Must only
+ * be called with interrupts disabled (i.e. from an interrupt handler) - the
+ * handlers are the only writers so need no other locking. If the queue is
+ * full the event is discarded (and counted).
+ */
+void add_input_event(uint8_t type, uint8_t value);
+
+/* Return 1 if there are events waiting to be read, 0 otherwise.
+ */
+uint8_t input_events_waiting(void);
+
+/* Remove the oldest event from the queue and copy it to *event. Returns 1
+ * if there was one, 0 (leaving *event unchanged) if the queue was empty.
+ */
+uint8_t get_input_event(InputEvent* event);
+
+/* Discard any events waiting to be read (input that happened when we
+ * didn't want it).
+ */
+void clear_input_events(void);
+
+/* Return the number of events that have been discarded because the queue
+ * was full (saturates at 255).
+ */
+uint8_t input_events_dropped(void);
+
+#endif /* INPUT_EVENTS_H_ */
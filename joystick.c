@@ -7,17 +7,76 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <avr/eeprom.h>
 #include <stdio.h>
 #include "joystick.h"
 #include "timer0.h"
+#include "input_events.h"
 
-// X/Y coordinate of joystick positions
+// Conversions are started by timer 0's compare match A (every millisecond
+// - see timer0.c) rather than being restarted at the end of each one, so
+// the ADC interrupt only happens once a millisecond. Each axis is sampled
+// SAMPLES_PER_AXIS times and the samples averaged, then the other axis is
+// sampled - so a new X and Y pair (and direction) every 8 ms.
+#define SAMPLES_PER_AXIS 4
+
+// The direction is looked up from the zone (low, middle or high) each 
+// axis is in. The zone of a value is looked up from the value divided by
+// 2^ZONE_SHIFT (the tables are built from the thresholds by 
+// build_zone_tables()). Values between the thresholds are in the middle
+// zone.
+#define ZONE_SHIFT 5
+#define NUM_ZONE_BINS (1024 >> ZONE_SHIFT)
+#define ZONE_LOW 0
+#define ZONE_MIDDLE 1
+#define ZONE_HIGH 2
+static uint8_t x_zones[NUM_ZONE_BINS];
+static uint8_t y_zones[NUM_ZONE_BINS];
+
+// Direction for each X zone (row) and Y zone (column). X increases to the
+// north, Y to the west.
+static const uint8_t zone_directions[3][3] PROGMEM = {
+	{SOUTH_EAST, SOUTH, SOUTH_WEST},
+	{EAST, CENTRE, WEST},
+	{NORTH_EAST, NORTH, NORTH_WEST}
+};
+
+// Thresholds (indexed by JOYSTICK_X_LOW etc.) - the defaults are used 
+// until the joystick is calibrated
+static uint16_t thresholds[NUM_JOYSTICK_THRESHOLDS] = {450, 550, 450, 550};
+
+// The calibration is kept in EEPROM after the saved game (bytes 0 to 181 -
+// see game.c), with a signature so we know it's there
+#define CALIBRATION_SIGNATURE 256
+#define CALIBRATION_SIGNATURE_SIZE 4
+#define CALIBRATION_THRESHOLDS 260
+#define CALIBRATION_THRESHOLDS_SIZE (NUM_JOYSTICK_THRESHOLDS * 2)
+static const char calibration_signature[CALIBRATION_SIGNATURE_SIZE] = "JCal";
+
+// The middle zone is this percentage of the distance from the centre to 
+// each end of the range found by calibration
+#define DEADZONE_PERCENT 40
+// Calibration is rejected if the joystick moved less than this from the 
+// centre in any direction
+#define MIN_CALIBRATION_RANGE 100
+
+// X/Y coordinate of joystick positions (averaged) and the direction they
+// give
 static volatile uint16_t x;
 static volatile uint16_t y;
+static volatile uint8_t current_joystick_dirn = CENTRE;
 
-// 0 if X value was converted lastly. Otherwise it's Y value
+// 0 if X value is being converted. Otherwise it's Y value
 static volatile uint8_t x_or_y;
 
+// Sum and number of the samples of the current axis taken so far
+static uint16_t sample_sum;
+static uint8_t sample_count;
+
+// Number of ADC interrupts (for measuring their CPU load)
+static volatile uint32_t interrupt_count;
+
 // The last time the joystick moved
 static uint32_t joystick_time = 0; // Originally hasn't moved
 
@@ -25,22 +84,71 @@ static uint32_t joystick_time = 0; // Originally hasn't moved
 static uint8_t joystick_dirn;
 static uint8_t last_joystick_dirn = CENTRE; // Originally at the centre
 
+// Fill in the zone of each bin of values, judged by the value in the 
+// middle of the bin
+static void build_zone_table(uint8_t* zones, uint16_t low, uint16_t high) {
+	for (uint8_t bin = 0; bin < NUM_ZONE_BINS; bin++) {
+		uint16_t value = (bin << ZONE_SHIFT) + (1 << (ZONE_SHIFT - 1));
+		if (value < low) {
+			zones[bin] = ZONE_LOW;
+		} else if (value > high) {
+			zones[bin] = ZONE_HIGH;
+		} else {
+			zones[bin] = ZONE_MIDDLE;
+		}
+	}
+}
+
+// Build the zone tables from the thresholds. The ADC interrupt (which 
+// uses the tables) is held off while they are changed.
+static void build_zone_tables(void) {
+	uint8_t adc_interrupt_was_enabled = ADCSRA & (1<<ADIE);
+	ADCSRA &= ~(1<<ADIE);
+	build_zone_table(x_zones, thresholds[JOYSTICK_X_LOW], thresholds[JOYSTICK_X_HIGH]);
+	build_zone_table(y_zones, thresholds[JOYSTICK_Y_LOW], thresholds[JOYSTICK_Y_HIGH]);
+	ADCSRA |= adc_interrupt_was_enabled;
+}
+
+// Load the thresholds saved by calibrate_joystick() if there are any 
+// (otherwise the defaults are kept)
+static void load_joystick_calibration(void) {
+	char eeprom_signature[CALIBRATION_SIGNATURE_SIZE];
+	
+	eeprom_read_block((void*)&eeprom_signature, (const void*)CALIBRATION_SIGNATURE, 
+			CALIBRATION_SIGNATURE_SIZE);
+	for (uint8_t i = 0; i < CALIBRATION_SIGNATURE_SIZE; i++) {
+		if (eeprom_signature[i] != calibration_signature[i]) {
+			return;
+		}
+	}
+	eeprom_read_block((void*)&thresholds, (const void*)CALIBRATION_THRESHOLDS,
+			CALIBRATION_THRESHOLDS_SIZE);
+}
+
 void init_joystick(void) {
 	
+	load_joystick_calibration();
+	build_zone_tables();
+	
 	ADMUX = (1<<REFS0);
 	
-	// Turn on the ADC (but don't start a conversion yet).
+	// Start conversions on timer 0 compare match A. (The conversion is 
+	// triggered by the interrupt flag being set so happens whether or 
+	// not the interrupt handler has run.)
+	ADCSRB = (1<<ADTS1)|(1<<ADTS0);
+	
+	// Turn on the ADC with auto triggering (conversions start once timer 0
+	// is running).
 	// Set up the conversion complete interrupt.
 	// Choose a clock divider of 64.
 	// Enable interrupt.
-	ADCSRA = (1<<ADEN)|(1<<ADIE)|(1<<ADPS2)|(1<<ADPS1);
+	ADCSRA = (1<<ADEN)|(1<<ADATE)|(1<<ADIE)|(1<<ADPS2)|(1<<ADPS1);
 	
 	x = 512;
 	y = 512;
 	x_or_y = 0;
-	
-	// Start the ADC conversion
-	ADCSRA |= (1<<ADSC);
+	sample_sum = 0;
+	sample_count = 0;
 }
 
 uint8_t has_joystick_moved(void) {
@@ -85,66 +193,120 @@ uint8_t get_last_joystick_dirn(void) {
 }
 
 uint32_t get_joystick_x(void) {
-	return x;
+	uint16_t value;
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	value = x;
+	if (interrupts_were_enabled) {
+		sei();
+	}
+	return value;
 }
 
 uint32_t get_joystick_y(void) {
-	return y;
+	uint16_t value;
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	value = y;
+	if (interrupts_were_enabled) {
+		sei();
+	}
+	return value;
 }
 
-uint8_t get_current_joystick_dirn(void) {
-
-	if (x < 550 && x > 450 && y < 550 && y > 450) {
-		return CENTRE;
-	} 
-	if (x > 570 && y < 570 && y > 430) {
-		return NORTH;
-	} 
-	if (x > 600 && y < 400) {
-		return NORTH_EAST;
-	} 
-	if (x < 550 && x > 450 && y < 450) {
-		return EAST;
-	}
-	if (x < 450 && y < 450) {
-		return SOUTH_EAST;
+// Work out the thresholds of one axis from its centre and range. Returns 
+// 0 if the range is too small to use.
+static uint8_t axis_thresholds(uint16_t* low, uint16_t* high,
+		uint16_t centre, uint16_t min, uint16_t max) {
+	if (min > centre || max < centre || centre - min < MIN_CALIBRATION_RANGE 
+			|| max - centre < MIN_CALIBRATION_RANGE) {
+		return 0;
 	}
-	if (x < 450 && y < 550 && y > 450) {
-		return SOUTH;
+	*low = centre - (uint32_t)(centre - min) * DEADZONE_PERCENT / 100;
+	*high = centre + (uint32_t)(max - centre) * DEADZONE_PERCENT / 100;
+	return 1;
+}
+
+uint8_t calibrate_joystick(uint16_t centre_x, uint16_t min_x, uint16_t max_x,
+		uint16_t centre_y, uint16_t min_y, uint16_t max_y) {
+	uint16_t new_thresholds[NUM_JOYSTICK_THRESHOLDS];
+	
+	if (!axis_thresholds(&new_thresholds[JOYSTICK_X_LOW], &new_thresholds[JOYSTICK_X_HIGH],
+				centre_x, min_x, max_x)
+			|| !axis_thresholds(&new_thresholds[JOYSTICK_Y_LOW], &new_thresholds[JOYSTICK_Y_HIGH],
+				centre_y, min_y, max_y)) {
+		return 0;
 	}
-	if (x < 450 && y > 550) {
-		return SOUTH_WEST;
+	for (uint8_t i = 0; i < NUM_JOYSTICK_THRESHOLDS; i++) {
+		thresholds[i] = new_thresholds[i];
 	}
-	if (x < 550 && x > 450 && y > 550) {
-		return WEST;
+	build_zone_tables();
+	
+	eeprom_update_block((const void*)&calibration_signature, (void*)CALIBRATION_SIGNATURE, 
+			CALIBRATION_SIGNATURE_SIZE);
+	eeprom_update_block((const void*)&thresholds, (void*)CALIBRATION_THRESHOLDS,
+			CALIBRATION_THRESHOLDS_SIZE);
+	return 1;
+}
+
+uint16_t get_joystick_threshold(uint8_t threshold) {
+	return thresholds[threshold];
+}
+
+uint8_t get_current_joystick_dirn(void) {
+	return current_joystick_dirn;
+}
+
+uint32_t get_joystick_interrupt_count(void) {
+	uint32_t count;
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	count = interrupt_count;
+	if (interrupts_were_enabled) {
+		sei();
 	}
-	if (x > 550 && y > 550) {
-		return NORTH_WEST;
+	return count;
+}
+
+void reset_joystick_interrupt_count(void) {
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	interrupt_count = 0;
+	if (interrupts_were_enabled) {
+		sei();
 	}
-	
-	return CENTRE;
 }
 
-// Interrupt for conversion of value X & Y when joystick is moved
+// Interrupt for conversion of value X & Y when joystick is moved. The next
+// conversion is started by timer 0.
 ISR(ADC_vect) {
-
-	uint16_t value = ADC;
 	
-	// Calculate values for either X or Y
+	interrupt_count++;
+	sample_sum += ADC;
+	if (++sample_count < SAMPLES_PER_AXIS) {
+		return;
+	}
+	uint16_t value = sample_sum / SAMPLES_PER_AXIS;
+	sample_sum = 0;
+	sample_count = 0;
+	
+	// Store the value and switch to the other axis (for the conversion
+	// started by the next timer 0 compare match)
 	if (x_or_y == 0) {
 		x = value;
+		x_or_y = 1;
+		ADMUX |= 1;
 	} else {
 		y = value;
-	}
-	
-	// Change x_or_y to 1 if last valued calculated was x and vice versa for y
-	x_or_y = 1 - x_or_y;
-	if (x_or_y == 0) {
+		x_or_y = 0;
 		ADMUX &= ~1;
-	} else { 
-		ADMUX |= 1;
+		
+		// We have a new X and Y pair - report a change of direction
+		uint8_t dirn = pgm_read_byte(
+				&zone_directions[x_zones[x >> ZONE_SHIFT]][y_zones[value >> ZONE_SHIFT]]);
+		if (dirn != current_joystick_dirn) {
+			current_joystick_dirn = dirn;
+			add_input_event(INPUT_JOYSTICK, dirn);
+		}
 	}
-	
-	//Start the ADC conversion again
-	ADCSRA |= (1<<ADSC);
 }
\ No newline at end of file
@@ -21,6 +21,9 @@
 #define WEST (7)
 #define NORTH_WEST (8)
 
+// Changes of direction are reported as INPUT_JOYSTICK events (see
+// input_events.h) with the new direction as the value
+
 uint8_t has_joystick_moved(void);
 void init_joystick(void);
 uint8_t get_current_joystick_dirn(void);
@@ -28,4 +31,26 @@ uint8_t get_last_joystick_dirn(void);
 uint32_t get_joystick_x(void);
 uint32_t get_joystick_y(void);
 
+// Thresholds between the middle of each axis and its low and high ends
+// (arguments to get_joystick_threshold() below)
+#define JOYSTICK_X_LOW 0
+#define JOYSTICK_X_HIGH 1
+#define JOYSTICK_Y_LOW 2
+#define JOYSTICK_Y_HIGH 3
+#define NUM_JOYSTICK_THRESHOLDS 4
+
+// Set the thresholds from the joystick's centre position and the least 
+// and greatest values seen on each axis, and save them to EEPROM (they are
+// loaded by init_joystick()). Returns 1 if successful, 0 (leaving the 
+// thresholds unchanged) if the joystick wasn't moved far enough from the 
+// centre in every direction.
+uint8_t calibrate_joystick(uint16_t centre_x, uint16_t min_x, uint16_t max_x,
+		uint16_t centre_y, uint16_t min_y, uint16_t max_y);
+uint16_t get_joystick_threshold(uint8_t threshold);
+
+// Number of ADC (joystick conversion) interrupts since the count was last
+// reset
+uint32_t get_joystick_interrupt_count(void);
+void reset_joystick_interrupt_count(void);
+
 #endif /* JOYSTICK_H_ */
\ No newline at end of file
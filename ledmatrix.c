@@ -17,6 +17,34 @@
 #define CMD_SHIFT_DISPLAY 0x04
 #define CMD_CLEAR_SCREEN 0x0F
 
+// Size (in SPI bytes) of each of the update commands
+#define PIXEL_UPDATE_BYTES 3
+#define ROW_UPDATE_BYTES (2 + MATRIX_NUM_COLUMNS)
+#define COLUMN_UPDATE_BYTES (2 + MATRIX_NUM_ROWS)
+#define ALL_UPDATE_BYTES (1 + MATRIX_NUM_COLUMNS * MATRIX_NUM_ROWS)
+
+// Shadow copy of what is currently shown on the LED matrix. Every command
+// sent to the matrix is also applied here so that ledmatrix_present() 
+// can work out which pixels have actually changed.
+static MatrixData shadow;
+
+// Count of SPI bytes sent to the matrix (in total and for the last frame
+// sent by ledmatrix_present())
+static uint32_t spi_bytes_sent;
+static uint16_t last_frame_spi_bytes;
+
+// All commands are queued for sending by the SPI interrupt handler, so
+// these functions return without waiting for the transfers to finish
+static void send_bytes(const uint8_t* bytes, uint8_t num_bytes) {
+	spi_send_bytes(bytes, num_bytes);
+	spi_bytes_sent += num_bytes;
+}
+
+static void send_command(uint8_t command, uint8_t argument) {
+	uint8_t bytes[2] = {command, argument};
+	send_bytes(bytes, 2);
+}
+
 void ledmatrix_setup(void) {
 	// Setup SPI - we divide the clock by 128.
 	// (This speed guarantees the SPI buffer will never overflow on
@@ -25,11 +53,16 @@ void ledmatrix_setup(void) {
 }
 
 void ledmatrix_update_all(MatrixData data) {
-	(void)spi_send_byte(CMD_UPDATE_ALL);
+	uint8_t command = CMD_UPDATE_ALL;
+	send_bytes(&command, 1);
+	// Data is sent a row at a time
 	for(uint8_t y=0; y<MATRIX_NUM_ROWS; y++) {
+		MatrixRow row;
 		for(uint8_t x=0; x<MATRIX_NUM_COLUMNS; x++) {
-			(void)spi_send_byte(data[x][y]);
+			row[x] = data[x][y];
+			shadow[x][y] = data[x][y];
 		}
+		send_bytes(row, MATRIX_NUM_COLUMNS);
 	}
 }
 
@@ -38,9 +71,9 @@ void ledmatrix_update_pixel(uint8_t x, uint8_t y, PixelColour pixel) {
 		// Position isn't valid - we ignore the request.
 		return;
 	}
-	(void)spi_send_byte(CMD_UPDATE_PIXEL);
-	(void)spi_send_byte( ((y & 0x07)<<4) | (x & 0x0F));
-	(void)spi_send_byte(pixel);
+	uint8_t bytes[3] = {CMD_UPDATE_PIXEL, ((y & 0x07)<<4) | (x & 0x0F), pixel};
+	send_bytes(bytes, 3);
+	shadow[x][y] = pixel;
 }
 
 void ledmatrix_update_row(uint8_t y, MatrixRow row) {
@@ -48,10 +81,10 @@ void ledmatrix_update_row(uint8_t y, MatrixRow row) {
 		// y value is too large - we ignore the request
 		return;
 	}
-	(void)spi_send_byte(CMD_UPDATE_ROW);
-	(void)spi_send_byte(y & 0x07);	// row number
+	send_command(CMD_UPDATE_ROW, y & 0x07);	// row number
+	send_bytes(row, MATRIX_NUM_COLUMNS);
 	for(uint8_t x = 0; x<MATRIX_NUM_COLUMNS; x++) {
-		(void)spi_send_byte(row[x]);
+		shadow[x][y] = row[x];
 	}
 }
 
@@ -60,35 +93,135 @@ void ledmatrix_update_column(uint8_t x, MatrixColumn col) {
 		// x value is too large - we ignore the request
 		return;
 	}
-	(void)spi_send_byte(CMD_UPDATE_COL);
-	(void)spi_send_byte(x & 0x0F); // column number
-	for(uint8_t y = 0; y<MATRIX_NUM_ROWS; y++) {
-		(void)spi_send_byte(col[y]);
-	}
+	send_command(CMD_UPDATE_COL, x & 0x0F); // column number
+	send_bytes(col, MATRIX_NUM_ROWS);
+	copy_matrix_column(col, shadow[x]);
 }
 
+// The shift commands move the display contents one pixel in the given
+// direction and blank the pixels that are shifted in.
 void ledmatrix_shift_display_left(void) {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x02);
+	send_command(CMD_SHIFT_DISPLAY, 0x02);
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS - 1; x++) {
+		copy_matrix_column(shadow[x+1], shadow[x]);
+	}
+	set_matrix_column_to_colour(shadow[MATRIX_NUM_COLUMNS - 1], COLOUR_BLACK);
 }
 
 void ledmatrix_shift_display_right(void) {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x01);
+	send_command(CMD_SHIFT_DISPLAY, 0x01);
+	for(uint8_t x = MATRIX_NUM_COLUMNS - 1; x > 0; x--) {
+		copy_matrix_column(shadow[x-1], shadow[x]);
+	}
+	set_matrix_column_to_colour(shadow[0], COLOUR_BLACK);
 }
 
 void ledmatrix_shift_display_up(void) {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x08);
+	send_command(CMD_SHIFT_DISPLAY, 0x08);
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		for(uint8_t y = MATRIX_NUM_ROWS - 1; y > 0; y--) {
+			shadow[x][y] = shadow[x][y-1];
+		}
+		shadow[x][0] = COLOUR_BLACK;
+	}
 }
 
 void ledmatrix_shift_display_down(void) {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x04);
+	send_command(CMD_SHIFT_DISPLAY, 0x04);
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS - 1; y++) {
+			shadow[x][y] = shadow[x][y+1];
+		}
+		shadow[x][MATRIX_NUM_ROWS - 1] = COLOUR_BLACK;
+	}
 }
 
 void ledmatrix_clear(void) {
-	(void)spi_send_byte(CMD_CLEAR_SCREEN);
+	uint8_t command = CMD_CLEAR_SCREEN;
+	send_bytes(&command, 1);
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		set_matrix_column_to_colour(shadow[x], COLOUR_BLACK);
+	}
+}
+
+// Number of SPI bytes needed to send n changed pixels in a row or column,
+// given the cost of updating the whole row or column instead
+static uint8_t update_cost(uint8_t num_changed, uint8_t whole_cost) {
+	uint8_t pixel_cost = num_changed * PIXEL_UPDATE_BYTES;
+	return (pixel_cost < whole_cost) ? pixel_cost : whole_cost;
+}
+
+void ledmatrix_present(MatrixData frame) {
+	uint32_t bytes_before = spi_bytes_sent;
+	uint8_t changed_in_row[MATRIX_NUM_ROWS];
+	uint8_t changed_in_column[MATRIX_NUM_COLUMNS];
+	uint16_t row_cost = 0;
+	uint16_t column_cost = 0;
+	
+	// Count the pixels in each row and column that differ from what is 
+	// currently displayed
+	for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+		changed_in_row[y] = 0;
+	}
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		changed_in_column[x] = 0;
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			if(frame[x][y] != shadow[x][y]) {
+				changed_in_column[x]++;
+				changed_in_row[y]++;
+			}
+		}
+		column_cost += update_cost(changed_in_column[x], COLUMN_UPDATE_BYTES);
+	}
+	for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+		row_cost += update_cost(changed_in_row[y], ROW_UPDATE_BYTES);
+	}
+	
+	// Send the changes using whichever takes the fewest SPI bytes - the
+	// whole display, or working row by row or column by column (sending
+	// either the changed pixels or the whole row/column)
+	if(row_cost == 0) {
+		// Nothing has changed
+	} else if(row_cost >= ALL_UPDATE_BYTES && column_cost >= ALL_UPDATE_BYTES) {
+		ledmatrix_update_all(frame);
+	} else if(column_cost < row_cost) {
+		for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+			if(changed_in_column[x] * PIXEL_UPDATE_BYTES > COLUMN_UPDATE_BYTES) {
+				ledmatrix_update_column(x, frame[x]);
+			} else if(changed_in_column[x] > 0) {
+				for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+					if(frame[x][y] != shadow[x][y]) {
+						ledmatrix_update_pixel(x, y, frame[x][y]);
+					}
+				}
+			}
+		}
+	} else {
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			if(changed_in_row[y] * PIXEL_UPDATE_BYTES > ROW_UPDATE_BYTES) {
+				MatrixRow row;
+				for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+					row[x] = frame[x][y];
+				}
+				ledmatrix_update_row(y, row);
+			} else if(changed_in_row[y] > 0) {
+				for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+					if(frame[x][y] != shadow[x][y]) {
+						ledmatrix_update_pixel(x, y, frame[x][y]);
+					}
+				}
+			}
+		}
+	}
+	last_frame_spi_bytes = spi_bytes_sent - bytes_before;
+}
+
+uint16_t ledmatrix_last_frame_bytes(void) {
+	return last_frame_spi_bytes;
+}
+
+uint32_t ledmatrix_bytes_sent(void) {
+	return spi_bytes_sent;
 }
 
 void copy_matrix_column(MatrixColumn from, MatrixColumn to) {
@@ -41,6 +41,18 @@ void ledmatrix_shift_display_up(void);
 void ledmatrix_shift_display_down(void);
 void ledmatrix_clear(void);
 
+// Bring the display up to date with the given frame, sending only what has
+// changed since the last update. Changed pixels are sent individually,
+// by row, by column or as a whole display - whichever needs the fewest
+// SPI bytes. If the display was shifted since the last frame, only the
+// pixels that differ after the shift are sent.
+void ledmatrix_present(MatrixData frame);
+
+// Number of SPI bytes sent by the last call to ledmatrix_present() and 
+// the total number of SPI bytes sent to the matrix since startup
+uint16_t ledmatrix_last_frame_bytes(void);
+uint32_t ledmatrix_bytes_sent(void);
+
 // Functions to operate on MatrixRow and MatrixColumn data structures
 void copy_matrix_column(MatrixColumn from, MatrixColumn to);
 void copy_matrix_row(MatrixRow from, MatrixRow to);
@@ -28,5 +28,21 @@
 // Cross
 #define LINE_VERTICAL_AND_HORIZONTAL			"\u253C"
 
+// The same lines in the VT100 DEC Special Graphics character set. These
+// are single bytes that only show as lines once the terminal has been
+// switched to that character set - see enter_line_drawing_mode() in
+// terminalio.h.
+#define DEC_LINE_VERTICAL				"x"
+#define DEC_LINE_HORIZONTAL				"q"
+#define DEC_LINE_DOWN_AND_RIGHT				"l"
+#define DEC_LINE_DOWN_AND_LEFT				"k"
+#define DEC_LINE_UP_AND_RIGHT				"m"
+#define DEC_LINE_UP_AND_LEFT				"j"
+#define DEC_LINE_VERTICAL_AND_RIGHT			"t"
+#define DEC_LINE_VERTICAL_AND_LEFT			"u"
+#define DEC_LINE_HORIZONTAL_AND_UP			"v"
+#define DEC_LINE_HORIZONTAL_AND_DOWN			"w"
+#define DEC_LINE_VERTICAL_AND_HORIZONTAL		"n"
+
 
 #endif /* LINE_DRAWING_CHARACTERS_H_ */
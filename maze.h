@@ -0,0 +1,71 @@
+/*
+** maze.h
+**
+** The layout of the maze and the ghost home. game.c builds the game field
+** and its tables from this, and host/maze_graph.c works out the junction
+** graph in maze_graph.h from it.
+*/
+
+#ifndef MAZE_H_
+#define MAZE_H_
+
+// Each row of the game field (row 0 is the top) as a string with one 
+// character for each of the 31 columns. Each character is one of the 
+// following values:
+// (space) - nothing at this location
+// - - horizontal wall at this location - uses LINE_HORIZONTAL
+// | - vertical wall at this location - uses LINE_VERTICAL
+// F - wall is down and to the right - uses LINE_DOWN_AND_RIGHT
+// 7 - wall is down and to the left - uses LINE_DOWN_AND_LEFT
+// L - wall is up and to the right - uses LINE_UP_AND_RIGHT
+// J - wall is up and to the left - uses LINE_UP_AND_LEFT
+// > - wall is vertical and to the right - uses LINE_VERTICAL_AND_RIGHT
+// < - wall is vertical and to the left - uses LINE_VERTICAL_AND_LEFT
+// ^ - wall is horizontal and up - uses LINE_HORIZONTAL_AND_UP
+// v - wall is horizontal and down - uses LINE_HORIZONTAL_AND_DOWN
+// + - wall is in all directions - uses LINE_VERTICAL_AND_HORIZONTAL
+// . - pacdot initially at this location
+// P - power pellet initial location (initially implemented just as a pac-dot)
+
+#define MAZE_ROW_0	"F-------------v-v-------------7"
+#define MAZE_ROW_1	"|.............| |.............|"
+#define MAZE_ROW_2	"|.F---7.F---7.| |.F---7.F---7.|"
+#define MAZE_ROW_3	"|.|   |.L---J.L-J.L---J.|   |.|"
+#define MAZE_ROW_4	"|.|   |.................|   |.|"
+#define MAZE_ROW_5	"|.|   |.F---7.F-7.F---7.|   |.|"
+#define MAZE_ROW_6	"|PL---J.L---J.L-J.L---J.L---JP|"
+#define MAZE_ROW_7	"|.............................|"
+#define MAZE_ROW_8	"|.F---7.F7.F-------7.F7.F---7.|"
+#define MAZE_ROW_9	"|.L---J.||.L--7 F--J.||.L---J.|"
+#define MAZE_ROW_10	"|.......||....| |....||.......|"
+#define MAZE_ROW_11	"L-----7.|L--7 | | F--J|.F-----J"
+#define MAZE_ROW_12	"      |.|F--J L-J L--7|.|      "
+#define MAZE_ROW_13	"      |.||           ||.|      "
+#define MAZE_ROW_14	"------J.LJ F--   --7 LJ.L------"
+#define MAZE_ROW_15	"       .   |       |   .       "
+#define MAZE_ROW_16	"------7.F7 L-------J F7.F------"
+#define MAZE_ROW_17	"      |.||           ||.|      "
+#define MAZE_ROW_18	"      |.|| F-------7 ||.|      "
+#define MAZE_ROW_19	"F-----J.LJ L--7 F--J LJ.L-----7"
+#define MAZE_ROW_20	"|.............| |.............|"
+#define MAZE_ROW_21	"|.F---7.F---7.| |.F---7.F---7.|"
+#define MAZE_ROW_22	"|.L-7 |.L---J.L-J.L---J.| F-J.|"
+#define MAZE_ROW_23	"|P..| |........ ........| |..P|"
+#define MAZE_ROW_24	">-7.| |.F7.F-------7.F7.| |.F-<"
+#define MAZE_ROW_25	">-J.L-J.||.L--7 F--J.||.L-J.L-<"
+#define MAZE_ROW_26	"|.......||....| |....||.......|"
+#define MAZE_ROW_27	"|.F-----JL--7.| |.F--JL-----7.|"
+#define MAZE_ROW_28	"|.L---------J.L-J.L---------J.|"
+#define MAZE_ROW_29	"|.............................|"
+#define MAZE_ROW_30	"L-----------------------------J"
+
+// Location of the ghost's home and of its entry (the row above it, where
+// the ghosts leave from). Ghosts can't move back into the home.
+#define GHOST_HOME_Y 15
+#define GHOST_HOME_X_LEFT 12
+#define GHOST_HOME_X_RIGHT 18
+#define GHOST_HOME_ENTRY_Y 14
+#define GHOST_HOME_ENTRY_X_LEFT 14
+#define GHOST_HOME_ENTRY_X_RIGHT 16
+
+#endif /* MAZE_H_ */
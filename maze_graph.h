@@ -0,0 +1,271 @@
+/*
+ * maze_graph.h
+ *
+ * Junction graph of the maze in maze.h for the ghosts - written by
+ * host/maze_graph.c (see there for how to run it). Don't edit this file,
+ * run that again if the maze changes.
+ *
+ * Nodes are the junctions, dead ends and tunnel ends the ghosts can reach
+ * (not the ghost home), numbered along each row in turn. Edges are the
+ * corridors joining them.
+ * - maze_node_cells[y] has bit x set if there is a node at (x,y) and
+ *   maze_node_row_first[y] is the number of the first node on row y.
+ * - maze_node_edges[node][dirn] is the edge leaving the node in direction
+ *   dirn (DIRN_LEFT etc.) or NO_MAZE_EDGE.
+ * - maze_edges[edge] gives the node at the other end, the number of moves
+ *   along the edge and where the directions of those moves start in
+ *   maze_edge_paths[]. That holds 2 bits per move, 4 moves to a byte with
+ *   the first in the low bits.
+ * The tunnel is an edge of length 1 between its two ends.
+ */
+
+#ifndef MAZE_GRAPH_H_
+#define MAZE_GRAPH_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "game.h"
+
+#define MAZE_NUM_NODES 40
+#define MAZE_NUM_EDGES 126
+#define NO_MAZE_NODE 0xFF
+#define NO_MAZE_EDGE 0xFF
+
+typedef struct {
+	uint16_t path;
+	uint8_t length;
+	uint8_t to;
+} MazeEdge;
+
+static const uint32_t maze_node_cells[FIELD_HEIGHT] PROGMEM = {
+	0x00000000,	// row 0
+	0x00800080,	// row 1
+	0x00000000,	// row 2
+	0x00000000,	// row 3
+	0x00822080,	// row 4
+	0x00000000,	// row 5
+	0x00000000,	// row 6
+	0x20922482,	// row 7
+	0x00000000,	// row 8
+	0x00000000,	// row 9
+	0x00800080,	// row 10
+	0x00000000,	// row 11
+	0x00000000,	// row 12
+	0x00022000,	// row 13
+	0x00000000,	// row 14
+	0x40900481,	// row 15
+	0x00000000,	// row 16
+	0x00100400,	// row 17
+	0x00000000,	// row 18
+	0x00000000,	// row 19
+	0x00900480,	// row 20
+	0x00000000,	// row 21
+	0x00000000,	// row 22
+	0x00922480,	// row 23
+	0x00000000,	// row 24
+	0x00000000,	// row 25
+	0x08000008,	// row 26
+	0x00000000,	// row 27
+	0x00000000,	// row 28
+	0x00022000,	// row 29
+	0x00000000	// row 30
+};
+
+static const uint8_t maze_node_row_first[FIELD_HEIGHT] PROGMEM = {
+	0, 0, 2, 2, 2, 6, 6, 6, 14, 14,
+	14, 16, 16, 16, 18, 18, 24, 24, 26, 26,
+	26, 30, 30, 30, 36, 36, 36, 38, 38, 38,
+	40
+};
+
+static const uint8_t maze_node_edges[MAZE_NUM_NODES][4] PROGMEM = {
+	{0, NO_MAZE_EDGE, 1, 2},	// 0: (7,1)
+	{3, NO_MAZE_EDGE, 4, 5},	// 1: (23,1)
+	{NO_MAZE_EDGE, 6, 7, 8},	// 2: (7,4)
+	{9, 10, 11, 12},	// 3: (13,4)
+	{13, 14, 15, 16},	// 4: (17,4)
+	{17, 18, NO_MAZE_EDGE, 19},	// 5: (23,4)
+	{NO_MAZE_EDGE, 20, 21, 22},	// 6: (1,7)
+	{23, 24, 25, 26},	// 7: (7,7)
+	{27, NO_MAZE_EDGE, 28, 29},	// 8: (10,7)
+	{30, 31, 32, NO_MAZE_EDGE},	// 9: (13,7)
+	{33, 34, 35, NO_MAZE_EDGE},	// 10: (17,7)
+	{36, NO_MAZE_EDGE, 37, 38},	// 11: (20,7)
+	{39, 40, 41, 42},	// 12: (23,7)
+	{43, 44, NO_MAZE_EDGE, 45},	// 13: (29,7)
+	{46, 47, NO_MAZE_EDGE, 48},	// 14: (7,10)
+	{NO_MAZE_EDGE, 49, 50, 51},	// 15: (23,10)
+	{52, 53, 54, NO_MAZE_EDGE},	// 16: (13,13)
+	{55, 56, 57, NO_MAZE_EDGE},	// 17: (17,13)
+	{58, NO_MAZE_EDGE, 59, NO_MAZE_EDGE},	// 18: (0,15)
+	{60, 61, 62, 63},	// 19: (7,15)
+	{64, 65, NO_MAZE_EDGE, 66},	// 20: (10,15)
+	{NO_MAZE_EDGE, 67, 68, 69},	// 21: (20,15)
+	{70, 71, 72, 73},	// 22: (23,15)
+	{74, NO_MAZE_EDGE, 75, NO_MAZE_EDGE},	// 23: (30,15)
+	{NO_MAZE_EDGE, 76, 77, 78},	// 24: (10,17)
+	{79, 80, NO_MAZE_EDGE, 81},	// 25: (20,17)
+	{82, 83, 84, 85},	// 26: (7,20)
+	{86, 87, 88, NO_MAZE_EDGE},	// 27: (10,20)
+	{89, 90, 91, NO_MAZE_EDGE},	// 28: (20,20)
+	{92, 93, 94, 95},	// 29: (23,20)
+	{NO_MAZE_EDGE, 96, 97, 98},	// 30: (7,23)
+	{99, NO_MAZE_EDGE, 100, 101},	// 31: (10,23)
+	{102, 103, 104, NO_MAZE_EDGE},	// 32: (13,23)
+	{105, 106, 107, NO_MAZE_EDGE},	// 33: (17,23)
+	{108, NO_MAZE_EDGE, 109, 110},	// 34: (20,23)
+	{111, 112, NO_MAZE_EDGE, 113},	// 35: (23,23)
+	{114, 115, 116, NO_MAZE_EDGE},	// 36: (3,26)
+	{117, 118, 119, NO_MAZE_EDGE},	// 37: (27,26)
+	{120, 121, 122, NO_MAZE_EDGE},	// 38: (13,29)
+	{123, 124, 125, NO_MAZE_EDGE}	// 39: (17,29)
+};
+
+static const MazeEdge maze_edges[MAZE_NUM_EDGES] PROGMEM = {
+	{0, 12, 6},	// 0: (7,1) left to (1,7)
+	{12, 9, 3},	// 1: (7,1) right to (13,4)
+	{21, 3, 2},	// 2: (7,1) down to (7,4)
+	{24, 9, 4},	// 3: (23,1) left to (17,4)
+	{33, 12, 13},	// 4: (23,1) right to (29,7)
+	{45, 3, 5},	// 5: (23,1) down to (23,4)
+	{48, 3, 0},	// 6: (7,4) up to (7,1)
+	{51, 6, 3},	// 7: (7,4) right to (13,4)
+	{57, 3, 7},	// 8: (7,4) down to (7,7)
+	{60, 6, 2},	// 9: (13,4) left to (7,4)
+	{66, 9, 0},	// 10: (13,4) up to (7,1)
+	{75, 4, 4},	// 11: (13,4) right to (17,4)
+	{79, 3, 9},	// 12: (13,4) down to (13,7)
+	{82, 4, 3},	// 13: (17,4) left to (13,4)
+	{86, 9, 1},	// 14: (17,4) up to (23,1)
+	{95, 6, 5},	// 15: (17,4) right to (23,4)
+	{101, 3, 10},	// 16: (17,4) down to (17,7)
+	{104, 6, 4},	// 17: (23,4) left to (17,4)
+	{110, 3, 1},	// 18: (23,4) up to (23,1)
+	{113, 3, 12},	// 19: (23,4) down to (23,7)
+	{116, 12, 0},	// 20: (1,7) up to (7,1)
+	{128, 6, 7},	// 21: (1,7) right to (7,7)
+	{134, 9, 14},	// 22: (1,7) down to (7,10)
+	{143, 6, 6},	// 23: (7,7) left to (1,7)
+	{149, 3, 2},	// 24: (7,7) up to (7,4)
+	{152, 3, 8},	// 25: (7,7) right to (10,7)
+	{155, 3, 14},	// 26: (7,7) down to (7,10)
+	{158, 3, 7},	// 27: (10,7) left to (7,7)
+	{161, 3, 9},	// 28: (10,7) right to (13,7)
+	{164, 9, 16},	// 29: (10,7) down to (13,13)
+	{173, 3, 8},	// 30: (13,7) left to (10,7)
+	{176, 3, 3},	// 31: (13,7) up to (13,4)
+	{179, 4, 10},	// 32: (13,7) right to (17,7)
+	{183, 4, 9},	// 33: (17,7) left to (13,7)
+	{187, 3, 4},	// 34: (17,7) up to (17,4)
+	{190, 3, 11},	// 35: (17,7) right to (20,7)
+	{193, 3, 10},	// 36: (20,7) left to (17,7)
+	{196, 3, 12},	// 37: (20,7) right to (23,7)
+	{199, 9, 17},	// 38: (20,7) down to (17,13)
+	{208, 3, 11},	// 39: (23,7) left to (20,7)
+	{211, 3, 5},	// 40: (23,7) up to (23,4)
+	{214, 6, 13},	// 41: (23,7) right to (29,7)
+	{220, 3, 15},	// 42: (23,7) down to (23,10)
+	{223, 6, 12},	// 43: (29,7) left to (23,7)
+	{229, 12, 1},	// 44: (29,7) up to (23,1)
+	{241, 9, 15},	// 45: (29,7) down to (23,10)
+	{250, 9, 6},	// 46: (7,10) left to (1,7)
+	{259, 3, 7},	// 47: (7,10) up to (7,7)
+	{262, 5, 19},	// 48: (7,10) down to (7,15)
+	{267, 3, 12},	// 49: (23,10) up to (23,7)
+	{270, 9, 13},	// 50: (23,10) right to (29,7)
+	{279, 5, 22},	// 51: (23,10) down to (23,15)
+	{284, 5, 20},	// 52: (13,13) left to (10,15)
+	{289, 9, 8},	// 53: (13,13) up to (10,7)
+	{298, 4, 17},	// 54: (13,13) right to (17,13)
+	{302, 4, 16},	// 55: (17,13) left to (13,13)
+	{306, 9, 11},	// 56: (17,13) up to (20,7)
+	{315, 5, 21},	// 57: (17,13) right to (20,15)
+	{320, 1, 23},	// 58: (0,15) left to (30,15) - tunnel
+	{321, 7, 19},	// 59: (0,15) right to (7,15)
+	{328, 7, 18},	// 60: (7,15) left to (0,15)
+	{335, 5, 14},	// 61: (7,15) up to (7,10)
+	{340, 3, 20},	// 62: (7,15) right to (10,15)
+	{343, 5, 26},	// 63: (7,15) down to (7,20)
+	{348, 3, 19},	// 64: (10,15) left to (7,15)
+	{351, 5, 16},	// 65: (10,15) up to (13,13)
+	{356, 2, 24},	// 66: (10,15) down to (10,17)
+	{358, 5, 17},	// 67: (20,15) up to (17,13)
+	{363, 3, 22},	// 68: (20,15) right to (23,15)
+	{366, 2, 25},	// 69: (20,15) down to (20,17)
+	{368, 3, 21},	// 70: (23,15) left to (20,15)
+	{371, 5, 15},	// 71: (23,15) up to (23,10)
+	{376, 7, 23},	// 72: (23,15) right to (30,15)
+	{383, 5, 29},	// 73: (23,15) down to (23,20)
+	{388, 7, 22},	// 74: (30,15) left to (23,15)
+	{395, 1, 18},	// 75: (30,15) right to (0,15) - tunnel
+	{396, 2, 20},	// 76: (10,17) up to (10,15)
+	{398, 10, 25},	// 77: (10,17) right to (20,17)
+	{408, 3, 27},	// 78: (10,17) down to (10,20)
+	{411, 10, 24},	// 79: (20,17) left to (10,17)
+	{421, 2, 21},	// 80: (20,17) up to (20,15)
+	{423, 3, 28},	// 81: (20,17) down to (20,20)
+	{426, 14, 36},	// 82: (7,20) left to (3,26)
+	{440, 5, 19},	// 83: (7,20) up to (7,15)
+	{445, 3, 27},	// 84: (7,20) right to (10,20)
+	{448, 3, 30},	// 85: (7,20) down to (7,23)
+	{451, 3, 26},	// 86: (10,20) left to (7,20)
+	{454, 3, 24},	// 87: (10,20) up to (10,17)
+	{457, 6, 32},	// 88: (10,20) right to (13,23)
+	{463, 6, 33},	// 89: (20,20) left to (17,23)
+	{469, 3, 25},	// 90: (20,20) up to (20,17)
+	{472, 3, 29},	// 91: (20,20) right to (23,20)
+	{475, 3, 28},	// 92: (23,20) left to (20,20)
+	{478, 5, 22},	// 93: (23,20) up to (23,15)
+	{483, 14, 37},	// 94: (23,20) right to (27,26)
+	{497, 3, 35},	// 95: (23,20) down to (23,23)
+	{500, 3, 26},	// 96: (7,23) up to (7,20)
+	{503, 3, 31},	// 97: (7,23) right to (10,23)
+	{506, 7, 36},	// 98: (7,23) down to (3,26)
+	{513, 3, 30},	// 99: (10,23) left to (7,23)
+	{516, 3, 32},	// 100: (10,23) right to (13,23)
+	{519, 9, 38},	// 101: (10,23) down to (13,29)
+	{528, 3, 31},	// 102: (13,23) left to (10,23)
+	{531, 6, 27},	// 103: (13,23) up to (10,20)
+	{537, 4, 33},	// 104: (13,23) right to (17,23)
+	{541, 4, 32},	// 105: (17,23) left to (13,23)
+	{545, 6, 28},	// 106: (17,23) up to (20,20)
+	{551, 3, 34},	// 107: (17,23) right to (20,23)
+	{554, 3, 33},	// 108: (20,23) left to (17,23)
+	{557, 3, 35},	// 109: (20,23) right to (23,23)
+	{560, 9, 39},	// 110: (20,23) down to (17,29)
+	{569, 3, 34},	// 111: (23,23) left to (20,23)
+	{572, 3, 29},	// 112: (23,23) up to (23,20)
+	{575, 7, 37},	// 113: (23,23) down to (27,26)
+	{582, 17, 38},	// 114: (3,26) left to (13,29)
+	{599, 14, 26},	// 115: (3,26) up to (7,20)
+	{613, 7, 30},	// 116: (3,26) right to (7,23)
+	{620, 7, 35},	// 117: (27,26) left to (23,23)
+	{627, 14, 29},	// 118: (27,26) up to (23,20)
+	{641, 17, 39},	// 119: (27,26) right to (17,29)
+	{658, 17, 36},	// 120: (13,29) left to (3,26)
+	{675, 9, 31},	// 121: (13,29) up to (10,23)
+	{684, 4, 39},	// 122: (13,29) right to (17,29)
+	{688, 4, 38},	// 123: (17,29) left to (13,29)
+	{692, 9, 34},	// 124: (17,29) up to (20,23)
+	{701, 17, 37}	// 125: (17,29) right to (27,26)
+};
+
+static const uint8_t maze_edge_paths[180] PROGMEM = {
+	0x00, 0xF0, 0xFF, 0xAA, 0xFA, 0xFF, 0x00, 0xF0, 0xAB, 0xEA, 0xFF, 0xFF,
+	0x95, 0xAA, 0xFE, 0x00, 0x50, 0x01, 0x80, 0xEA, 0x0F, 0x50, 0xA9, 0xAA,
+	0xAA, 0xFE, 0x00, 0x50, 0xFD, 0x55, 0xA5, 0xAA, 0xAA, 0xFA, 0xAB, 0x2A,
+	0x00, 0x54, 0xEA, 0x0F, 0xA8, 0xBF, 0xFA, 0x03, 0x95, 0x2A, 0x40, 0xA5,
+	0x02, 0xEA, 0x0F, 0xFC, 0x40, 0xA5, 0xAA, 0x3F, 0x00, 0x54, 0x15, 0x00,
+	0xFC, 0x00, 0x00, 0x00, 0x55, 0xF5, 0x7F, 0xA5, 0xAA, 0xD5, 0xFF, 0xC0,
+	0x57, 0x40, 0xA5, 0x0A, 0x50, 0xA9, 0x95, 0xFA, 0xA8, 0xAA, 0x00, 0x40,
+	0x55, 0xEA, 0xFF, 0x40, 0xA9, 0x5F, 0x80, 0xFA, 0x40, 0x55, 0xAA, 0xEA,
+	0xFF, 0x00, 0x80, 0xA5, 0xAA, 0xAA, 0x3F, 0x00, 0x00, 0xD4, 0x0F, 0x00,
+	0xBF, 0xFE, 0x55, 0xA9, 0x3F, 0x50, 0xA9, 0x3F, 0xF0, 0x57, 0x2A, 0x50,
+	0x95, 0xAA, 0xFE, 0xF0, 0xFF, 0x95, 0xFA, 0x03, 0x00, 0xEA, 0xAF, 0xFE,
+	0x40, 0x05, 0xA8, 0x02, 0x54, 0xAA, 0x0A, 0xA8, 0x3F, 0xF0, 0x03, 0xD5,
+	0xAF, 0x0A, 0xBF, 0xAA, 0xAA, 0x6A, 0x05, 0x95, 0xAA, 0xAA, 0x56, 0x00,
+	0x55, 0xA5, 0x15, 0x00, 0xE8, 0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x50,
+	0x69, 0x05, 0x54, 0xAA, 0x00, 0x95, 0x5A, 0xA9, 0xAA, 0xAA, 0x56, 0x00
+};
+
+#endif /* MAZE_GRAPH_H_ */
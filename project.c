@@ -10,10 +10,13 @@
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "ledmatrix.h"
+#include "spi.h"
 #include "scrolling_char_display.h"
 #include "buttons.h"
+#include "input_events.h"
 #include "serialio.h"
 #include "terminalio.h"
 #include "score.h"
@@ -23,10 +26,12 @@
 #include "buzzer.h"
 #include "seve_seg_display.h"
 #include "joystick.h"
+#include "scheduler.h"
 #include "ledmatrix.h"
 
 #define F_CPU 8000000L
 #include <util/delay.h>
+#include <avr/sleep.h>
 
 // Function prototypes - these are defined below (after main()) in the order
 // given here
@@ -36,10 +41,44 @@ void new_game(void);
 void play_game(void);
 void handle_level_complete(void);
 void handle_game_over(void);
+void display_performance_stats(void);
+static void change_baud_rate(void);
+static void display_baud_rate(void);
+static void idle_sleep(void);
+static void wait_for_input_event(InputEvent* event);
+static uint8_t game_event_pending(void);
+static void record_input_latency(uint16_t event_time);
+static void request_diagonal(int8_t first, int8_t second, uint16_t input_time);
+static void run_joystick_calibration(void);
 
-// ASCII code for Escape character
-#define ESCAPE_CHAR 27
 uint8_t seven_seg_data[10] = {63,6,91,79,102,109,125,7,127,111};
+
+// Baud rates the 'b' key steps through (starting from the first). The 
+// terminal has to be changed to match - 'r' redraws the screen once it has.
+static const uint32_t baud_rates[] PROGMEM = {19200, 38400, 57600, 76800, 115200};
+#define NUM_BAUD_RATES (sizeof(baud_rates) / sizeof(baud_rates[0]))
+static uint8_t baud_rate_index;
+
+// Performance measurements - CPU cycles spent in each pass of the 
+// play_game() loop. Displayed (and reset) with the 'm' key.
+static uint32_t loop_cycles_total;
+static uint32_t loop_cycles_max;
+static uint16_t loop_iterations;
+
+// Serial (terminal) output - bytes sent since the statistics were last
+// displayed and the most sent in one pass of the play_game() loop
+static uint32_t stats_start_serial_bytes;
+static uint16_t loop_serial_bytes_max;
+
+// CPU cycles spent asleep waiting for something to happen (out of the 
+// cycles since stats_start_cycles) and the time (ms) between input events
+// happening and them being read by play_game()
+static uint32_t stats_start_cycles;
+static uint32_t idle_cycles_total;
+static uint32_t input_latency_total;
+static uint16_t input_latency_max;
+static uint16_t input_count;
+
 /////////////////////////////// main //////////////////////////////////
 int main(void) {
 	// Setup hardware and call backs. This will turn on 
@@ -53,7 +92,7 @@ int main(void) {
 	// Initialize lives 
 	init_lives();
 	
-	set_prescalar(2);
+	play_sound(SOUND_NEW_GAME);
 	
 	while(1) {
 		new_game();
@@ -74,9 +113,9 @@ void initialise_hardware(void) {
 	
 	ledmatrix_setup();
 	init_button_interrupts();
-	// Setup serial port for 19200 baud communication with no echo
-	// of incoming characters
-	init_serial_stdio(19200,0);
+	// Setup serial port for communication at the first of our baud rates
+	// (19200) with no echo of incoming characters
+	init_serial_stdio(pgm_read_dword(&baud_rates[0]),0);
 	
 	// Buzzer
 	init_buzzer();
@@ -85,6 +124,12 @@ void initialise_hardware(void) {
 	init_joystick();
 	
 	init_timer0();
+	
+	// When there's nothing to do we sleep in idle mode - the timers, 
+	// serial port, pin change and ADC interrupts all wake us up (the ADC 
+	// converts once a millisecond, started by timer 0 - see joystick.c)
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	
 	// Turn on global interrupts
 	sei();
 }
@@ -108,8 +153,9 @@ void splash_screen(void) {
 		// Scroll the message until it has scrolled off the 
 		// display or a button is pushed
 		while(scroll_display()) {
+			InputEvent event;
 			_delay_ms(150);
-			if(button_pushed() != NO_BUTTON_PUSHED) {
+			if(get_input_event(&event) && event.type == INPUT_BUTTON) {
 				ledmatrix_clear();
 				reset_timer0();
 				return;
@@ -119,7 +165,7 @@ void splash_screen(void) {
 }
 
 void completely_new_game(void) {
-	set_prescalar(2);
+	play_sound(SOUND_NEW_GAME);
 	new_game();
 	reset_power_pellet_eaten();
 	reset_dead_ghosts();
@@ -138,112 +184,98 @@ void new_game(void) {
 	init_score();
 	
 	// Clear a button push or serial input if any are waiting
-	// (The cast to void means the return value is ignored.)
-	(void)button_pushed();
-	clear_serial_input_buffer();
+	clear_input_events();
 }
 
 void play_game(void) {
 	uint32_t current_time;
-	uint32_t pacman_last_move_time;
-	uint32_t ghost_last_move_time;
-	uint32_t ghost_last_move_time2;
-	uint32_t ghost_last_move_time3;
-	uint32_t ghost_last_move_time4;
+	int8_t task;
+	InputEvent event;
 	int8_t button;
-	char serial_input, escape_sequence_char;
-	uint8_t characters_into_escape_sequence = 0;
+	char serial_input, arrow;
 	uint32_t power_pellet_eaten_time = 0;
+	uint32_t loop_start_cycles;
+	uint32_t loop_cycles;
+	uint32_t loop_start_serial_bytes;
+	uint32_t loop_serial_bytes;
+	uint32_t idle_start_cycles;
+	uint8_t joystick_dirn = get_current_joystick_dirn();
+	uint16_t joystick_time = (uint16_t)get_current_time();
 	
-	// Get the current time and remember this as the last time the projectiles
-    // were moved.
+	// Get the current time and schedule the first moves of the pac-man and
+	// ghosts from this time
 	current_time = get_current_time();
-	pacman_last_move_time = current_time;
-	ghost_last_move_time = current_time;
-	ghost_last_move_time2 = current_time;
-	ghost_last_move_time3 = current_time;
-	ghost_last_move_time4 = current_time;
+	scheduler_reset(current_time);
 
 	// We play the game until it's over
 	while(!is_game_over()) {	
-		// Check for input - which could be a button push or serial input.
-		// Serial input may be part of an escape sequence, e.g. ESC [ D
-		// is a left cursor key press. At most one of the following three
-		// variables will be set to a value other than -1 if input is available.
-		// (We don't initalise button to -1 since button_pushed() will return -1
-		// if no button pushes are waiting to be returned.)
-		// Button pushes take priority over serial input. If there are both then
-		// we'll retrieve the serial input the next time through this loop
+		// Sleep until there is something to do. Interrupts are disabled 
+		// while we check so that one can't happen between the check and
+		// going to sleep (and leave us asleep with something to do).
+		idle_start_cycles = get_current_cycles();
+		cli();
+		while(!game_event_pending()) {
+			idle_sleep();
+		}
+		sei();
+		loop_start_cycles = get_current_cycles();
+		idle_cycles_total += loop_start_cycles - idle_start_cycles;
+		loop_start_serial_bytes = serial_output_byte_count();
+		
+		// Check for input - the next input event (if any) is a button push,
+		// a key, a cursor key (the serial port has already decoded its 
+		// escape sequence) or a change of joystick direction. At most one 
+		// of the following three variables will be set to a value other 
+		// than -1. Any further events are handled on the following passes.
+		button = -1;
 		serial_input = -1;
-		escape_sequence_char = -1;
-		button = button_pushed();
+		arrow = -1;
+		if(get_input_event(&event)) {
+			record_input_latency(event.time);
+			if(event.type == INPUT_BUTTON) {
+				button = event.value;
+			} else if(event.type == INPUT_KEY) {
+				serial_input = event.value;
+			} else if(event.type == INPUT_ARROW) {
+				arrow = event.value;
+			} else {
+				joystick_dirn = event.value;
+				joystick_time = event.time;
+			}
+		}
 		power_pellet_eaten_time = get_power_pellet_time();
 		
-		// Ledmatrix
-		draw_ledmatrix_game();	
-		
 		if (get_power_pellet_eaten() && current_time >= power_pellet_eaten_time + 15000) {
 			reset_power_pellet_eaten();
 			reset_dead_ghosts();
 			set_alive_pellet_ghosts();
 			reset_last_ghost_score();
-			PORTC = 0;
-		}
-		
-		if(button == NO_BUTTON_PUSHED) {
-			// No push button was pushed, see if there is any serial input
-			if(serial_input_available()) {
-				// Serial data was available - read the data from standard input
-				serial_input = fgetc(stdin);
-				// Check if the character is part of an escape sequence
-				if(characters_into_escape_sequence == 0 && serial_input == ESCAPE_CHAR) {
-					// We've hit the first character in an escape sequence (escape)
-					characters_into_escape_sequence++;
-					serial_input = -1; // Don't further process this character
-				} else if(characters_into_escape_sequence == 1 && serial_input == '[') {
-					// We've hit the second character in an escape sequence
-					characters_into_escape_sequence++;
-					serial_input = -1; // Don't further process this character
-				} else if(characters_into_escape_sequence == 2) {
-					// Third (and last) character in the escape sequence
-					escape_sequence_char = serial_input;
-					serial_input = -1;  // Don't further process this character - we
-										// deal with it as part of the escape sequence
-					characters_into_escape_sequence = 0;
-				} else {
-					// Character was not part of an escape sequence (or we received
-					// an invalid second character in the sequence). We'll process 
-					// the data in the serial_input variable.
-					characters_into_escape_sequence = 0;
-				}
-			}
 		}
 		
-		// Process the input. 
-		if(button==3 || escape_sequence_char=='D') {
-			// Button 3 pressed OR left cursor key escape sequence completed 
+		// Process the input. Turns that can't be made yet are remembered
+		// and made as soon as they can be (see request_pacman_direction())
+		if(button==3 || arrow==ARROW_LEFT) {
+			// Button 3 pressed OR left cursor key 
 			// Attempt to move left
-			change_pacman_direction(DIRN_LEFT);
-		} else if(button==2 || escape_sequence_char=='A') {
-			// Button 2 pressed or up cursor key escape sequence completed
-			change_pacman_direction(DIRN_UP);
-		} else if(button==1 || escape_sequence_char=='B') {
-			// Button 1 pressed OR down cursor key escape sequence completed
-			change_pacman_direction(DIRN_DOWN);
-		} else if(button==0 || escape_sequence_char=='C') {
-			// Button 0 pressed OR right cursor key escape sequence completed 
+			request_pacman_direction(DIRN_LEFT, event.time);
+		} else if(button==2 || arrow==ARROW_UP) {
+			// Button 2 pressed or up cursor key
+			request_pacman_direction(DIRN_UP, event.time);
+		} else if(button==1 || arrow==ARROW_DOWN) {
+			// Button 1 pressed OR down cursor key
+			request_pacman_direction(DIRN_DOWN, event.time);
+		} else if(button==0 || arrow==ARROW_RIGHT) {
+			// Button 0 pressed OR right cursor key 
 			// Attempt to move right
-			change_pacman_direction(DIRN_RIGHT);
+			request_pacman_direction(DIRN_RIGHT, event.time);
 		} else if(serial_input == 'p' || serial_input == 'P') {
 			pause_time();
 			pause_ssg();
 			change_game_paused();
 			while(1) {
-				if (button_pushed()){
-					// do nothing
-				}
-				if(serial_input_available()) {
-					serial_input = fgetc(stdin);
+				wait_for_input_event(&event);
+				if(event.type == INPUT_KEY) {
+					serial_input = event.value;
 					if(serial_input == 'p' || serial_input =='P') {
 						unpause_time();
 						unpause_ssg();
@@ -255,104 +287,115 @@ void play_game(void) {
 					} else if (serial_input == 'o' || serial_input == 'O') {
 						if (signature_check()) {
 							load_game();
+							scheduler_reset(get_current_time());
 							break;
 						}
 					}
 				}
 			}
 			change_game_paused();
+			// Joystick events were ignored while paused
+			joystick_dirn = get_current_joystick_dirn();
+			joystick_time = (uint16_t)get_current_time();
 		} else if (serial_input == 'n' || serial_input == 'N') {
 			completely_new_game();
-		// else - invalid input or we're part way through an escape sequence -
-		// do nothing
+		// else - invalid input - do nothing
 		} else if (serial_input == 's' || serial_input == 'S') {
 			save_game();
+		} else if (serial_input == 'm' || serial_input == 'M') {
+			display_performance_stats();
+		} else if (serial_input == 'g' || serial_input == 'G') {
+			toggle_wall_graphics_mode();
+		} else if (serial_input == 'b' || serial_input == 'B') {
+			change_baud_rate();
+			scheduler_reset(get_current_time());
+		} else if (serial_input == 'r' || serial_input == 'R') {
+			redraw_game_field();
+			scheduler_reset(get_current_time());
+		} else if (serial_input == 'j' || serial_input == 'J') {
+			pause_time();
+			pause_ssg();
+			run_joystick_calibration();
+			unpause_time();
+			unpause_ssg();
+			joystick_dirn = get_current_joystick_dirn();
+			joystick_time = (uint16_t)get_current_time();
 		} else if (serial_input == 'o' || serial_input == 'O') {
 			if (signature_check()) {
 				pause_ssg();
 				load_game();
-				ghost_last_move_time = get_current_time();
-				ghost_last_move_time2 = get_current_time();
-				ghost_last_move_time3 = get_current_time();
-				ghost_last_move_time4 = get_current_time();
-				pacman_last_move_time = get_current_time();
+				scheduler_reset(get_current_time());
 				unpause_ssg();	
 			}
 		} else {
-			if (get_current_joystick_dirn() == 1) {
-				change_pacman_direction(DIRN_UP);
-			} else if (get_current_joystick_dirn() == 2) {
-				if (!(change_pacman_direction(DIRN_UP))) {
-					change_pacman_direction(DIRN_RIGHT);
-				} else {
-					change_pacman_direction(DIRN_UP);
-				}
-			} else if (get_current_joystick_dirn() == 3) {
-				change_pacman_direction(DIRN_RIGHT);
-			} else if (get_current_joystick_dirn() == 4) {
-				if (!(change_pacman_direction(DIRN_DOWN))) {
-					change_pacman_direction(DIRN_RIGHT);
-				} else {
-					change_pacman_direction(DIRN_DOWN);
-				}
-			} else if (get_current_joystick_dirn() == 5) {
-				change_pacman_direction(DIRN_DOWN);
-			} else if (get_current_joystick_dirn() == 6) {
-				if (!(change_pacman_direction(DIRN_DOWN))) {
-					change_pacman_direction(DIRN_LEFT);
-				} else {
-					change_pacman_direction(DIRN_DOWN);
-				}
-			} else if (get_current_joystick_dirn() == 7) {
-				change_pacman_direction(DIRN_LEFT);
-			} else if (get_current_joystick_dirn() == 8) {
-				if (!(change_pacman_direction(DIRN_UP))) {
-					change_pacman_direction(DIRN_LEFT);
-				} else {
-					change_pacman_direction(DIRN_UP);
-				}
+			// Point the pac-man the way the joystick is held (the direction 
+			// is only sampled once per pass - from the last joystick event)
+			if (joystick_dirn == 1) {
+				request_pacman_direction(DIRN_UP, joystick_time);
+			} else if (joystick_dirn == 2) {
+				request_diagonal(DIRN_UP, DIRN_RIGHT, joystick_time);
+			} else if (joystick_dirn == 3) {
+				request_pacman_direction(DIRN_RIGHT, joystick_time);
+			} else if (joystick_dirn == 4) {
+				request_diagonal(DIRN_DOWN, DIRN_RIGHT, joystick_time);
+			} else if (joystick_dirn == 5) {
+				request_pacman_direction(DIRN_DOWN, joystick_time);
+			} else if (joystick_dirn == 6) {
+				request_diagonal(DIRN_DOWN, DIRN_LEFT, joystick_time);
+			} else if (joystick_dirn == 7) {
+				request_pacman_direction(DIRN_LEFT, joystick_time);
+			} else if (joystick_dirn == 8) {
+				request_diagonal(DIRN_UP, DIRN_LEFT, joystick_time);
 			}
 		}
 		
 		
 		current_time = get_current_time();
 		
-		if(!is_game_over() && current_time >= pacman_last_move_time + 400) {
-			// 400ms (0.4 second) has passed since the last time we moved 
-			// the pac-man - move it.
-			move_pacman();
-			pacman_last_move_time = current_time;
-			
-			// Check if the move finished the level - and restart if so
-			if(is_level_complete()) {
-				handle_level_complete();	// This will pause until a button is pushed
-				initialise_game_level();
-				// Update our timers since we have a pause above
-				pacman_last_move_time = ghost_last_move_time4 = ghost_last_move_time2 =
-				ghost_last_move_time3 = ghost_last_move_time = get_current_time();
+		// Move the pac-man and the ghosts that are due to move (each has its
+		// own period - see scheduler.c)
+		while(!is_game_over() && (task = scheduler_next_due_task(current_time)) >= 0) {
+			if(task == TASK_MOVE_PACMAN) {
+				move_pacman();
+				
+				// Check if the move finished the level - and restart if so
+				if(is_level_complete()) {
+					handle_level_complete();	// This will pause until a button is pushed
+					initialise_game_level();
+					// Restart our timers since we have a pause above
+					current_time = get_current_time();
+					scheduler_reset(current_time);
+					joystick_dirn = get_current_joystick_dirn();
+					joystick_time = (uint16_t)current_time;
+				}
+			} else if(get_dead_ghost(task - TASK_MOVE_GHOST_0)) {
+				// Ghost is alive - move it
+				move_ghost(task - TASK_MOVE_GHOST_0);
 			}
 		}
-		if(!is_game_over() && current_time >= ghost_last_move_time + 500 &&
-			get_dead_ghost(0)) {
-			// 500ms (0.5 second) has passed since the last time we moved the
-			// ghosts - move them
-			move_ghost(0);
-			ghost_last_move_time = current_time;
-		}
-		if (!is_game_over() && current_time >= ghost_last_move_time2 + 525 &&
-			get_dead_ghost(1)) {
-			move_ghost(1);
-			ghost_last_move_time2 = current_time;
+		
+		// Update the power pellet countdown on the seven segment display
+		// (only does anything once a second)
+		update_ssg(current_time);
+		
+		// Send any cell updates that were held back because the serial 
+		// link was busy (if there is now room)
+		draw_deferred_cells();
+		
+		// Ledmatrix - show the result of any moves made above
+		draw_ledmatrix_game();
+		
+		loop_cycles = get_current_cycles() - loop_start_cycles;
+		if (loop_iterations < UINT16_MAX) {
+			loop_cycles_total += loop_cycles;
+			loop_iterations++;
 		}
-		if (!is_game_over() && current_time >= ghost_last_move_time3 + 550 &&
-			get_dead_ghost(2)) {
-			move_ghost(2);
-			ghost_last_move_time3 = current_time;
+		if (loop_cycles > loop_cycles_max) {
+			loop_cycles_max = loop_cycles;
 		}
-		if (!is_game_over() && current_time >= ghost_last_move_time4 + 600 &&
-			get_dead_ghost(3)) {
-			move_ghost(3);
-			ghost_last_move_time4 = current_time;
+		loop_serial_bytes = serial_output_byte_count() - loop_start_serial_bytes;
+		if (loop_serial_bytes > loop_serial_bytes_max) {
+			loop_serial_bytes_max = loop_serial_bytes;
 		}
 	}
 	// We get here if the game is over.
@@ -363,14 +406,13 @@ void handle_level_complete(void) {
 	printf_P(PSTR("Level complete"));
 	move_cursor(35,11);
 	printf_P(PSTR("Push a button or key to continue"));
-	// Clear any characters in the serial input buffer - to make
-	// sure we only use key presses from now on.
-	clear_serial_input_buffer();
-	while(button_pushed() == NO_BUTTON_PUSHED && !serial_input_available()) {
-		; // wait
-	}
-	// Throw away any characters in the serial input buffer
-	clear_serial_input_buffer();
+	// Clear any input waiting - to make sure we only use button and key
+	// presses from now on.
+	clear_input_events();
+	InputEvent event;
+	wait_for_input_event(&event);
+	// Throw away anything else that has happened
+	clear_input_events();
 
 }
 
@@ -381,15 +423,230 @@ void handle_game_over(void) {
 	printf_P(PSTR("GAME OVER"));
 	move_cursor(35,16);
 	printf_P(PSTR("Press a button to start again"));
-	while(button_pushed() == NO_BUTTON_PUSHED) {
-		int serial_input = -1;
-		if (serial_input_available()) {
-			serial_input = fgetc(stdin);
-			if (serial_input == 'N' || serial_input == 'n') {
-				break;
-				; // wait
-			}
+	while(1) {
+		InputEvent event;
+		wait_for_input_event(&event);
+		if (event.type == INPUT_BUTTON) {
+			break;
+		} else if (event.type == INPUT_KEY && (event.value == 'N' || event.value == 'n')) {
+			break;
 		}
 	} 
 	completely_new_game();		
 }
+
+void display_performance_stats(void) {
+	// Average and worst case CPU cycles per pass of the game loop since
+	// the last time the statistics were displayed
+	move_cursor(33, 20);
+	printf_P(PSTR("Loop cycles avg: %8lu"), 
+			loop_iterations ? loop_cycles_total / loop_iterations : 0);
+	move_cursor(33, 21);
+	printf_P(PSTR("Loop cycles max: %8lu"), loop_cycles_max);
+	move_cursor(33, 22);
+	printf_P(PSTR("LED SPI bytes/frame: %5u"), ledmatrix_last_frame_bytes());
+	move_cursor(33, 23);
+	printf_P(PSTR("LED render cycles: %5u"), get_ledmatrix_render_cycles());
+	move_cursor(33, 24);
+	printf_P(PSTR("SPI queue high water: %3u"), spi_queue_high_water_mark());
+	move_cursor(33, 25);
+	uint32_t serial_bytes = serial_output_byte_count() - stats_start_serial_bytes;
+	uint32_t elapsed_ms = (get_current_cycles() - stats_start_cycles) / 8000;
+	printf_P(PSTR("UART bytes: %8lu %6lu/s"), serial_bytes, 
+			serial_bytes * 1000 / (elapsed_ms + 1));
+	move_cursor(33, 26);
+	printf_P(PSTR("UART bytes/pass max: %5u"), loop_serial_bytes_max);
+	move_cursor(33, 27);
+	printf_P(PSTR("Draw UTF-8 %5lu B %4u ms DEC %5lu B %4u ms"), 
+			get_level_draw_bytes(WALLS_UNICODE), get_level_draw_ms(WALLS_UNICODE),
+			get_level_draw_bytes(WALLS_DEC_GRAPHICS), 
+			get_level_draw_ms(WALLS_DEC_GRAPHICS));
+	move_cursor(33, 28);
+	printf_P(PSTR("Flow field cycles: %6lu max %6lu"), 
+			get_flow_field_cycles(), get_flow_field_cycles_max());
+	move_cursor(33, 29);
+	// Average latency in tenths of a millisecond
+	uint32_t latency_avg = input_count ? input_latency_total * 10 / input_count : 0;
+	printf_P(PSTR("Input latency avg: %3lu.%lu ms max %5u ms"), 
+			latency_avg / 10, latency_avg % 10, input_latency_max);
+	move_cursor(33, 30);
+	uint32_t elapsed_cycles = get_current_cycles() - stats_start_cycles;
+	printf_P(PSTR("Idle: %3u%%  Input events dropped: %3u"), 
+			(uint16_t)(idle_cycles_total / (elapsed_cycles / 100 + 1)),
+			input_events_dropped());
+	move_cursor(33, 31);
+	printf_P(PSTR("Cells deferred: %5u coalesced: %5u"), 
+			get_cells_deferred(), get_cells_coalesced());
+	move_cursor(33, 33);
+	// Average time from a turn being asked for to it being made, in
+	// tenths of a millisecond
+	uint16_t turns = get_turns_made();
+	uint32_t turn_avg = turns ? get_turn_latency_total() * 10 / turns : 0;
+	printf_P(PSTR("Turn latency avg: %3lu.%lu ms max %5u ms"), 
+			turn_avg / 10, turn_avg % 10, get_turn_latency_max());
+	move_cursor(33, 34);
+	printf_P(PSTR("Turns: %5u pre-turns: %5u expired: %5u"), 
+			turns, get_preturns_made(), get_preturns_expired());
+	move_cursor(33, 35);
+	printf_P(PSTR("Joystick ADC interrupts: %5lu/s"), 
+			get_joystick_interrupt_count() * 1000 / (elapsed_ms + 1));
+	move_cursor(33, 36);
+	printf_P(PSTR("7-seg ISR max: %4u cycles"), get_ssg_isr_cycles_max());
+	display_baud_rate();
+	move_cursor(33, PERFORMANCE_STATS_LAST_ROW);
+	printf_P(PSTR("Level restart: %5lu bytes %5u ms"), 
+			get_level_restart_bytes(), get_level_restart_ms());
+	
+	loop_cycles_total = 0;
+	loop_cycles_max = 0;
+	loop_iterations = 0;
+	loop_serial_bytes_max = 0;
+	stats_start_serial_bytes = serial_output_byte_count();
+	idle_cycles_total = 0;
+	input_latency_total = 0;
+	input_latency_max = 0;
+	input_count = 0;
+	reset_flow_field_cycles_max();
+	reset_deferred_cell_counts();
+	reset_turn_counts();
+	reset_joystick_interrupt_count();
+	reset_ssg_isr_cycles_max();
+	stats_start_cycles = get_current_cycles();
+}
+
+// Calibrate the joystick - sample its centre position, then the least and
+// greatest values of each axis while it is moved around its full range. 
+// The prompts and the result are shown beside the game field.
+static void run_joystick_calibration(void) {
+	InputEvent event;
+	uint16_t centre_x, centre_y, min_x, max_x, min_y, max_y, value;
+	
+	move_cursor(33, 37);
+	printf_P(PSTR("Joystick: leave it centred and push a button"));
+	clear_to_end_of_line();
+	clear_input_events();
+	do {
+		wait_for_input_event(&event);
+	} while (event.type != INPUT_BUTTON);
+	centre_x = min_x = max_x = get_joystick_x();
+	centre_y = min_y = max_y = get_joystick_y();
+	
+	move_cursor(33, 37);
+	printf_P(PSTR("Joystick: move to every edge, push a button"));
+	clear_to_end_of_line();
+	while (!(get_input_event(&event) && event.type == INPUT_BUTTON)) {
+		value = get_joystick_x();
+		if (value < min_x) {
+			min_x = value;
+		} else if (value > max_x) {
+			max_x = value;
+		}
+		value = get_joystick_y();
+		if (value < min_y) {
+			min_y = value;
+		} else if (value > max_y) {
+			max_y = value;
+		}
+	}
+	
+	move_cursor(33, 37);
+	if (calibrate_joystick(centre_x, min_x, max_x, centre_y, min_y, max_y)) {
+		printf_P(PSTR("Joystick calibrated: X %u-%u Y %u-%u"),
+				get_joystick_threshold(JOYSTICK_X_LOW), get_joystick_threshold(JOYSTICK_X_HIGH),
+				get_joystick_threshold(JOYSTICK_Y_LOW), get_joystick_threshold(JOYSTICK_Y_HIGH));
+	} else {
+		printf_P(PSTR("Joystick not moved far enough - not calibrated"));
+	}
+	clear_to_end_of_line();
+	clear_input_events();
+}
+
+// Switch to the next of our baud rates, once what has already been output
+// has been sent at the old rate, and redraw the screen at the new rate
+// (which measures how long a full redraw takes at that rate)
+static void change_baud_rate(void) {
+	baud_rate_index = (baud_rate_index + 1) % NUM_BAUD_RATES;
+	uint32_t baudrate = pgm_read_dword(&baud_rates[baud_rate_index]);
+	move_cursor(33, 32);
+	printf_P(PSTR("Changing to %lu baud"), baudrate);
+	serial_set_baud(baudrate);
+	redraw_game_field();
+	display_baud_rate();
+}
+
+// Show the baud rate, how far the actual rate is from it and the rate the
+// last full draw of the field (in the current wall mode) got on to the 
+// screen at
+static void display_baud_rate(void) {
+	int16_t error = serial_baud_error();
+	uint8_t mode = get_wall_graphics_mode();
+	move_cursor(33, 32);
+	printf_P(PSTR("Baud: %6lu error %c%d.%d%% draw %5lu B/s"), 
+			serial_get_baud(), error < 0 ? '-' : '+', abs(error) / 10, 
+			abs(error) % 10,
+			get_level_draw_bytes(mode) * 1000 / (get_level_draw_ms(mode) + 1));
+	clear_to_end_of_line();
+}
+
+// Sleep (in idle mode) until an interrupt happens. Must be called with
+// interrupts disabled (after checking that there's nothing to do) and 
+// returns with them disabled again. The instruction after sei() is always
+// executed before any interrupt is handled, so an interrupt can't sneak in
+// between enabling interrupts and going to sleep.
+static void idle_sleep(void) {
+	sleep_enable();
+	sei();
+	sleep_cpu();
+	sleep_disable();
+	cli();
+}
+
+// Sleep until there is a button push or key (or cursor key) and return
+// it. Joystick events are discarded.
+static void wait_for_input_event(InputEvent* event) {
+	while(1) {
+		cli();
+		while(!input_events_waiting()) {
+			idle_sleep();
+		}
+		sei();
+		if(get_input_event(event) && event->type != INPUT_JOYSTICK) {
+			return;
+		}
+	}
+}
+
+// Returns 1 if the game loop has something to do: an input event to 
+// handle, a pac-man or ghost move is due, the power pellet has worn off or
+// deferred cell updates can now be sent. (Sending serial output wakes us 
+// up, so we notice when room is made for them.)
+static uint8_t game_event_pending(void) {
+	uint32_t current_time = get_current_time();
+	return input_events_waiting() || deferred_cells_drawable() ||
+			scheduler_time_until_due(current_time) == 0 ||
+			(get_power_pellet_eaten() && current_time >= get_power_pellet_time() + 15000) ||
+			ssg_update_due(current_time);
+}
+
+// The joystick is held diagonally - turn the first way if possible. If not,
+// turn (or keep going) the second way but remember the first so the turn
+// is made as soon as it can be.
+static void request_diagonal(int8_t first, int8_t second, uint16_t input_time) {
+	if (!request_pacman_direction(first, input_time)) {
+		request_pacman_direction(second, input_time);
+		request_pacman_direction(first, input_time);
+	}
+}
+
+// Record how long an input event (which happened at the given time - the 
+// low 16 bits of get_current_time()) waited before play_game() read it
+static void record_input_latency(uint16_t event_time) {
+	uint16_t latency = (uint16_t)get_current_time() - event_time;
+	if (input_count < UINT16_MAX) {
+		input_latency_total += latency;
+		input_count++;
+	}
+	if (latency > input_latency_max) {
+		input_latency_max = latency;
+	}
+}
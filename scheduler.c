@@ -0,0 +1,70 @@
+/*
+ * scheduler.c
+ *
+ * With only a few tasks, a linear search of the due times is cheaper than
+ * maintaining a heap - and it only happens when a task actually runs (or
+ * a period changes). The rest of the time the cached earliest due time 
+ * is all that is looked at. Times are compared by their difference so
+ * that they can wrap around.
+ */
+
+#include "scheduler.h"
+
+// Default periods (ms) of the tasks
+static const uint16_t default_periods[NUM_TASKS] = {
+	400,	// pac-man
+	500,	// ghost 0
+	525,	// ghost 1
+	550,	// ghost 2
+	600		// ghost 3
+};
+
+static uint16_t periods[NUM_TASKS];
+static uint32_t due_times[NUM_TASKS];
+static uint32_t earliest_due_time;
+
+static void find_earliest_due_time(void) {
+	earliest_due_time = due_times[0];
+	for(uint8_t task = 1; task < NUM_TASKS; task++) {
+		if((int32_t)(due_times[task] - earliest_due_time) < 0) {
+			earliest_due_time = due_times[task];
+		}
+	}
+}
+
+void scheduler_reset(uint32_t current_time) {
+	for(uint8_t task = 0; task < NUM_TASKS; task++) {
+		periods[task] = default_periods[task];
+		due_times[task] = current_time + periods[task];
+	}
+	find_earliest_due_time();
+}
+
+void scheduler_set_period(uint8_t task, uint16_t period) {
+	// Work out when the task last ran from its old period
+	due_times[task] = due_times[task] - periods[task] + period;
+	periods[task] = period;
+	find_earliest_due_time();
+}
+
+int8_t scheduler_next_due_task(uint32_t current_time) {
+	if((int32_t)(current_time - earliest_due_time) < 0) {
+		// Nothing is due yet
+		return -1;
+	}
+	for(uint8_t task = 0; task < NUM_TASKS; task++) {
+		if((int32_t)(current_time - due_times[task]) >= 0) {
+			due_times[task] = current_time + periods[task];
+			find_earliest_due_time();
+			return task;
+		}
+	}
+	return -1;
+}
+
+uint32_t scheduler_time_until_due(uint32_t current_time) {
+	if((int32_t)(current_time - earliest_due_time) >= 0) {
+		return 0;
+	}
+	return earliest_due_time - current_time;
+}
@@ -0,0 +1,43 @@
+/*
+ * scheduler.h
+ *
+ * Schedules the regular moves of the game's entities (the pac-man and the 
+ * ghosts). Each task has a period (in milliseconds, i.e. timer0 ticks) 
+ * and is due one period after it last ran. The earliest due time is kept
+ * so the main loop only needs one comparison to find that nothing is due
+ * and can tell how long it has until something is.
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <stdint.h>
+
+// Tasks - lower numbered tasks are run first when more than one is due
+#define TASK_MOVE_PACMAN 0
+#define TASK_MOVE_GHOST_0 1		// Ghost n is TASK_MOVE_GHOST_0 + n
+#define NUM_TASKS 5
+
+/* Restore every task's default period and make each due one period from
+ * the given time. Used whenever the game (re)starts - a new game, a new 
+ * level or after a saved game is loaded.
+ */
+void scheduler_reset(uint32_t current_time);
+
+/* Change a task's period (e.g. to speed up or slow down an entity). The
+ * new period is measured from when the task last ran.
+ */
+void scheduler_set_period(uint8_t task, uint16_t period);
+
+/* Return the lowest numbered task that is due at the given time and 
+ * schedule its next run one period from then, or return -1 if no task is
+ * due. Call repeatedly to get every task that is due.
+ */
+int8_t scheduler_next_due_task(uint32_t current_time);
+
+/* Return the number of milliseconds from the given time until the next 
+ * task is due (0 if one is due now).
+ */
+uint32_t scheduler_time_until_due(uint32_t current_time);
+
+#endif /* SCHEDULER_H_ */
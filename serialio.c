@@ -8,52 +8,117 @@
  * any standard IO methods (e.g. printf). We use interrupt-based output
  * and a circular buffer to store output messages. (This allows us 
  * to print many characters at once to the buffer and have them 
- * output by the UART as speed permits.) If the buffer fills up, the
- * put method will either
+ * output by the UART as speed permits.) serial_write() adds a block of
+ * bytes at once, without going through stdio. If the buffer fills up,
+ * the put method (and serial_write()) will either
  * (1) if interrupts are enabled, block until there is room in it, or
  * (2) if interrupts are disabled, will discard the character.
- * Input is blocking - requesting input from stdin will block
- * until a character is available. If interrupts are disabled when 
- * input is sought, then this will block forever.
- * The function input_available() can be used to test whether there is
- * input available to read from stdin.
+ * Input is not read through stdin. Each character received is decoded
+ * as it arrives (by the receive interrupt handler) and added to the 
+ * input event queue (see input_events.h) - as a cursor key event if it
+ * completes a cursor key escape sequence, or as a key event otherwise.
  *
  */
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#include "serialio.h"
+#include "input_events.h"
 
 /* System clock rate in Hz. (L at the end indicates this is a long constant) */
 #define SYSCLK 8000000L
 
 /* Global variables */
-/* Circular buffer to hold outgoing characters. The insert_pos variable
- * keeps track of the position (0 to OUTPUT_BUFFER_SIZE-1) that the next
- * outgoing character should be written to. bytes_in_buffer keeps
- * count of the number of characters currently stored in the buffer 
- * (ranging from 0 to OUTPUT_BUFFER_SIZE). This number of bytes immediately
- * prior to the current insert_pos are the bytes waiting to be output.
- * If the insert_pos reaches the end of the buffer it will wrap around
- * to the beginning (assuming those bytes have been output).
- * NOTE - OUTPUT_BUFFER_SIZE can not be larger than 255 without changing
- * the type of the variables below (currently defined as 8 bit unsigned ints).
+/* Circular buffer to hold outgoing characters. Characters are added at
+ * tx_head by uart_put_char() and serial_write() and removed from tx_tail
+ * by the UART data register empty interrupt handler. Output only happens
+ * from the main program (never from an interrupt handler) so there is one
+ * writer and one reader, and each position is only changed by one of 
+ * them. Neither needs to turn interrupts off to add or remove characters
+ * - except that a position of more than one byte can't be read or written
+ * in one go, so the main program turns them off briefly for that (once 
+ * per call, not per character). The buffer size must be a power of 2 so 
+ * positions can wrap with a mask. One slot is always left empty so that
+ * a full buffer can be told from an empty one.
+ */
+#define TX_BUFFER_MASK (SERIAL_TX_BUFFER_SIZE - 1)
+#if SERIAL_TX_BUFFER_SIZE > 256
+typedef uint16_t tx_position_t;
+#else
+typedef uint8_t tx_position_t;
+#endif
+static char tx_buffer[SERIAL_TX_BUFFER_SIZE];
+static volatile tx_position_t tx_head;
+static volatile tx_position_t tx_tail;
+
+/* The baud rate asked for and the error in the rate actually used, in
+ * tenths of a percent (see set_baud_rate())
  */
-#define OUTPUT_BUFFER_SIZE 255
-volatile char out_buffer[OUTPUT_BUFFER_SIZE];
-volatile uint8_t out_insert_pos;
-volatile uint8_t bytes_in_out_buffer;
+static uint32_t baud_rate;
+static int16_t baud_error;
 
-/* Circular buffer to hold incoming characters. Works on same principle
- * as output buffer
+/* Count of the number of bytes that have been written to the output 
+ * buffer (wraps around when it overflows). Used to measure output and to
+ * detect whether anything has been output.
  */
-#define INPUT_BUFFER_SIZE 16
-volatile char input_buffer[INPUT_BUFFER_SIZE];
-volatile uint8_t input_insert_pos;
-volatile uint8_t bytes_in_input_buffer;
-volatile uint8_t input_overrun;
+static uint32_t output_byte_count;
+
+/* Escape sequence decoder. Cursor keys send ESC [ A to ESC [ D (or
+ * ESC O A to ESC O D in "application" mode). Each character received moves
+ * the decoder from its current state according to the character's class,
+ * and may add events. escape_sequence_table[state][class] gives the next
+ * state (low nibble) and the events to add (high nibble).
+ * An ESC on its own (the Escape key) is only known to be one when nothing
+ * follows it - the timer0 interrupt handler calls serial_input_tick() every
+ * millisecond, which reports it after ESCAPE_TIMEOUT ms. (A terminal sends
+ * the characters of a sequence together.) A sequence that stops part way
+ * (e.g. ESC [ and nothing more) is dropped after the same time, so that 
+ * it doesn't swallow the next key.
+ */
+#define ESCAPE_CHAR 27
+#define ESCAPE_TIMEOUT 20
+
+// Decoder states
+#define SEQ_NONE 0			// Not in a sequence
+#define SEQ_ESCAPE 1		// Had ESC
+#define SEQ_INTRODUCED 2	// Had ESC [ or ESC O (and possibly parameters)
+
+// Character classes
+#define CHAR_OTHER 0
+#define CHAR_ESCAPE 1		// ESC
+#define CHAR_INTRODUCER 2	// [ or O
+#define CHAR_ARROW 3		// A to D
+#define CHAR_PARAMETER 4	// 0 to 9 or ; (parameters of other sequences)
+#define NUM_CHAR_CLASSES 5
+
+// Events to add (combined)
+#define EMIT_ESCAPE 0x10	// Key event for a lone ESC (added first)
+#define EMIT_KEY 0x20		// Key event for this character
+#define EMIT_ARROW 0x40		// Cursor key event for this character
+
+static const uint8_t escape_sequence_table[3][NUM_CHAR_CLASSES] PROGMEM = {
+	// SEQ_NONE - everything but ESC is an ordinary key
+	{ SEQ_NONE | EMIT_KEY, SEQ_ESCAPE, SEQ_NONE | EMIT_KEY,
+			SEQ_NONE | EMIT_KEY, SEQ_NONE | EMIT_KEY },
+	// SEQ_ESCAPE - the ESC was on its own unless [ or O follows
+	{ SEQ_NONE | EMIT_ESCAPE | EMIT_KEY, SEQ_ESCAPE | EMIT_ESCAPE, 
+			SEQ_INTRODUCED, SEQ_NONE | EMIT_ESCAPE | EMIT_KEY,
+			SEQ_NONE | EMIT_ESCAPE | EMIT_KEY },
+	// SEQ_INTRODUCED - a cursor key (with or without parameters - modified
+	// keys send e.g. ESC [ 1 ; 5 A), or a sequence we don't use (which is
+	// discarded up to and including its final character)
+	{ SEQ_NONE, SEQ_ESCAPE, SEQ_NONE, SEQ_NONE | EMIT_ARROW, SEQ_INTRODUCED }
+};
+
+static volatile uint8_t escape_sequence_state;
+static volatile uint8_t escape_timeout;
 
 /* Variable to keep track of whether incoming characters are to be echoed
  * back or not.
@@ -64,24 +129,56 @@ static int8_t do_echo;
  */
 void init_serial_stdio(long baudrate, int8_t echo);
 static int uart_put_char(char, FILE*);
-static int uart_get_char(FILE*);
 
-/* Setup a stream that uses the uart get and put functions. We will
- * make standard input and output use this stream below.
+/* Setup a stream that uses the uart put function. We will make standard
+ * output use this stream below.
  */
-static FILE myStream = FDEV_SETUP_STREAM(uart_put_char, uart_get_char,
-		_FDEV_SETUP_RW);
+static FILE myStream = FDEV_SETUP_STREAM(uart_put_char, NULL,
+		_FDEV_SETUP_WRITE);
+
+/* Set the baud rate registers for the given rate. The UART divides the
+ * clock by 16 (or by 8 with U2X0 set) and by UBRR0 + 1, so only some rates
+ * can be made exactly. We work out the nearest rate both ways and use
+ * double speed if it is nearer - e.g. at 8MHz 57600 is 3.5% out at normal
+ * speed and 2.1% at double speed, and 76800 and 115200 are only usable at
+ * double speed. (Normal speed samples each bit more times, so is used if
+ * they are equally good.)
+ */
+static void set_baud_rate(uint32_t baudrate) {
+	/* (This differs from the datasheet formula so that we get 
+	 * rounding to the nearest integer while using integer division
+	 * (which truncates)).
+	*/
+	uint16_t ubrr_normal = ((SYSCLK / (8 * baudrate)) + 1)/2 - 1;
+	uint16_t ubrr_double = ((SYSCLK / (4 * baudrate)) + 1)/2 - 1;
+	int32_t error_normal = SYSCLK / (16 * (ubrr_normal + 1L)) - baudrate;
+	int32_t error_double = SYSCLK / (8 * (ubrr_double + 1L)) - baudrate;
+	int32_t error;
+	
+	if(labs(error_double) < labs(error_normal)) {
+		UBRR0 = ubrr_double;
+		UCSR0A = (1<<U2X0);
+		error = error_double;
+	} else {
+		UBRR0 = ubrr_normal;
+		UCSR0A = 0;
+		error = error_normal;
+	}
+	baud_rate = baudrate;
+	/* Round to the nearest tenth of a percent */
+	error *= 1000;
+	error += (error < 0) ? -(int32_t)(baudrate / 2) : (int32_t)(baudrate / 2);
+	baud_error = error / (int32_t)baudrate;
+}
 
 void init_serial_stdio(long baudrate, int8_t echo) {
-	uint16_t ubrr;
 	/*
 	 * Initialise our buffers
 	*/
-	out_insert_pos = 0;
-	bytes_in_out_buffer = 0;
-	input_insert_pos = 0;
-	bytes_in_input_buffer = 0;
-	input_overrun = 0;
+	tx_head = 0;
+	tx_tail = 0;
+	escape_sequence_state = SEQ_NONE;
+	escape_timeout = 0;
 	
 	/*
 	 * Record whether we're going to echo characters or not
@@ -89,12 +186,7 @@ void init_serial_stdio(long baudrate, int8_t echo) {
 	do_echo = echo;
 	
 	/* Configure the serial port baud rate */
-	/* (This differs from the datasheet formula so that we get 
-	 * rounding to the nearest integer while using integer division
-	 * (which truncates)).
-	*/
-	ubrr = ((SYSCLK / (8 * baudrate)) + 1)/2 - 1;
-	UBRR0 = ubrr;
+	set_baud_rate(baudrate);
 	
 	/*
 	 * Enable transmission and receiving via UART. We don't enable
@@ -110,27 +202,102 @@ void init_serial_stdio(long baudrate, int8_t echo) {
 	*/
 	UCSR0B  |= (1 <<RXCIE0);
 
-	/* Set up our stream so the put and get functions below are used 
-	 * to write/read characters via the serial port when we use
-	 * stdio functions
+	/* Set up our stream so the put function below is used to write
+	 * characters via the serial port when we use stdio functions
 	*/
 	stdout = &myStream;
-	stdin = &myStream;
 }
 
-int8_t serial_input_available(void) {
-	return (bytes_in_input_buffer != 0);
+uint32_t serial_output_byte_count(void) {
+	/* Only changed by the main program, so no need to turn interrupts off */
+	return output_byte_count;
+}
+
+/* Clear the transmit complete flag (by writing a 1 to it) without 
+ * changing the speed setting. Done after each character is written to
+ * UDR0 - the flag can't be set again until that character has gone.
+ */
+static void clear_transmit_complete(void) {
+	UCSR0A = (UCSR0A & (1<<U2X0)) | (1<<TXC0);
+}
+
+/* Return the position the interrupt handler will take the next character
+ * from
+ */
+static tx_position_t get_tx_tail(void) {
+#if SERIAL_TX_BUFFER_SIZE > 256
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	tx_position_t tail = tx_tail;
+	if(interrupts_enabled) {
+		sei();
+	}
+	return tail;
+#else
+	return tx_tail;
+#endif
+}
+
+/* Make the characters before the given position available to the interrupt
+ * handler and make sure it is enabled to send them
+ */
+static void set_tx_head(tx_position_t head) {
+#if SERIAL_TX_BUFFER_SIZE > 256
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	tx_head = head;
+	if(interrupts_enabled) {
+		sei();
+	}
+#else
+	/* The characters must be in the buffer before the new head position 
+	 * is - stop the compiler moving the buffer writes after this. (cli()
+	 * does the same above.)
+	 */
+	__asm__ __volatile__ ("" ::: "memory");
+	tx_head = head;
+#endif
+	/* If the interrupt handler empties the buffer and disables itself
+	 * between us reading and writing UCSR0B, it just fires once more 
+	 * (finds nothing to send) and disables itself again.
+	 */
+	UCSR0B |= (1 << UDRIE0);
+}
+
+void serial_flush(void) {
+	/* Wait for the buffer to empty, then for the last character to
+	 * be shifted out. (The transmit complete flag is cleared each time
+	 * a character is written to UDR0, so it can't be left over from 
+	 * an earlier character.)
+	 */
+	while(get_tx_tail() != tx_head) {
+		if(!bit_is_set(SREG, SREG_I)) {
+			return;
+		}
+	}
+	while(!(UCSR0A & (1<<TXC0))) {
+		/* do nothing */
+	}
+}
+
+void serial_set_baud(uint32_t baudrate) {
+	serial_flush();
+	set_baud_rate(baudrate);
+}
+
+uint32_t serial_get_baud(void) {
+	return baud_rate;
 }
 
-void clear_serial_input_buffer(void) {
-	/* Just adjust our buffer data so it looks empty */
-	input_insert_pos = 0;
-	bytes_in_input_buffer = 0;
+int16_t serial_baud_error(void) {
+	return baud_error;
+}
+
+uint16_t serial_tx_space(void) {
+	return (get_tx_tail() - tx_head - 1) & TX_BUFFER_MASK;
 }
 
 static int uart_put_char(char c, FILE* stream) {
-	uint8_t interrupts_enabled;
-	
 	/* Add the character to the buffer for transmission (if there 
 	 * is space to do so). If not we wait until the buffer has space.
 	 * If the character is \n, we output \r (carriage return)
@@ -144,73 +311,55 @@ static int uart_put_char(char c, FILE* stream) {
 	 * abort - we don't output the character since the buffer will
 	 * never be emptied if interrupts are disabled. If the buffer is full
 	 * and interrupts are enabled then we loop until the buffer has 
-	 * enough space. The bytes_in_buffer variable will get modified by the
-	 * ISR which extracts bytes from the buffer.
+	 * space. The tail position will get modified by the ISR which
+	 * extracts characters from the buffer.
 	*/
-	interrupts_enabled = bit_is_set(SREG, SREG_I);
-	while(bytes_in_out_buffer >= OUTPUT_BUFFER_SIZE) {
-		if(!interrupts_enabled) {
+	tx_position_t head = tx_head;
+	tx_position_t next_head = (head + 1) & TX_BUFFER_MASK;
+	if(next_head == get_tx_tail()) {
+		if(!bit_is_set(SREG, SREG_I)) {
 			return 1;
-		}		
-		/* else do nothing */
-	}
-	
-	/* Add the character to the buffer for transmission if there
-	 * is space to do so. We advance the insert_pos to the next
-	 * character position. If this is beyond the end of the buffer
-	 * we wrap around back to the beginning of the buffer 
-	 * NOTE: we disable interrupts before modifying the buffer. This
-	 * prevents the ISR from modifying the buffer at the same time.
-	 * We reenable them if they were enabled when we entered the
-	 * function.
-	*/	
-	cli();
-	out_buffer[out_insert_pos++] = c;
-	bytes_in_out_buffer++;
-	if(out_insert_pos == OUTPUT_BUFFER_SIZE) {
-		/* Wrap around buffer pointer if necessary */
-		out_insert_pos = 0;
-	}
-	/* Reenable interrupts (UDR Empty interrupt may have been
-	 * disabled) - we ensure it is now enabled so that it will
-	 * fire and deal with the next character in the buffer. */
-	UCSR0B |= (1 << UDRIE0);
-	if(interrupts_enabled) {
-		sei();
+		}
+		while(next_head == get_tx_tail()) {
+			/* do nothing */
+		}
 	}
+	tx_buffer[head] = c;
+	set_tx_head(next_head);
+	output_byte_count++;
 	return 0;
 }
 
-int uart_get_char(FILE* stream) {
-	/* Wait until we've received a character */
-	while(bytes_in_input_buffer == 0) {
-		/* do nothing */
-	}
+void serial_write(const char* data, uint16_t length) {
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	tx_position_t head = tx_head;
 	
-	/*
-	 * Turn interrupts off and remove a character from the input
-	 * buffer. We reenable interrupts if they were on.
-	 * The pending character is the one which is byte_in_input_buffer
-	 * characters before the insert position (taking into account
-	 * that we may need to wrap around).
+	/* Copy as much as there is space for - in at most two pieces if the
+	 * free space wraps around the end of the buffer - then wait for more
+	 * space if need be (or discard the rest if interrupts are off).
 	 */
-	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
-	cli();
-	char c;
-	if(input_insert_pos - bytes_in_input_buffer < 0) {
-		/* Need to wrap around */
-		c = input_buffer[input_insert_pos - bytes_in_input_buffer
-				+ INPUT_BUFFER_SIZE];
-	} else {
-		c = input_buffer[input_insert_pos - bytes_in_input_buffer];
+	while(length > 0) {
+		uint16_t space = (get_tx_tail() - head - 1) & TX_BUFFER_MASK;
+		if(space == 0) {
+			if(!interrupts_enabled) {
+				return;
+			}
+			continue;
+		}
+		uint16_t count = SERIAL_TX_BUFFER_SIZE - head;
+		if(count > space) {
+			count = space;
+		}
+		if(count > length) {
+			count = length;
+		}
+		memcpy(&tx_buffer[head], data, count);
+		data += count;
+		length -= count;
+		head = (head + count) & TX_BUFFER_MASK;
+		set_tx_head(head);
+		output_byte_count += count;
 	}
-	
-	/* Decrement our count of bytes in the input buffer */
-	bytes_in_input_buffer--;
-	if(interrupts_enabled) {
-		sei();
-	}	
-	return c;
 }
 
 /*
@@ -220,28 +369,14 @@ int uart_get_char(FILE* stream) {
 ISR(USART0_UDRE_vect) 
 {
 	/* Check if we have data in our buffer */
-	if(bytes_in_out_buffer > 0) {
-		/* Yes we do - remove the pending byte and output it
-		 * via the UART. The pending byte (character) is the
-		 * one which is "bytes_in_buffer" characters before the 
-		 * insert_pos (taking into account that we may 
-		 * need to wrap around to the end of the buffer).
+	tx_position_t tail = tx_tail;
+	if(tail != tx_head) {
+		/* Yes we do - output the character at the tail via the UART
+		 * and move the tail on past it
 		 */
-		char c;
-		if(out_insert_pos - bytes_in_out_buffer < 0) {
-			/* Need to wrap around */
-			c = out_buffer[out_insert_pos - bytes_in_out_buffer
-				+ OUTPUT_BUFFER_SIZE];
-		} else {
-			c = out_buffer[out_insert_pos - bytes_in_out_buffer];
-		}
-		/* Decrement our count of the number of bytes in the 
-		 * buffer 
-		 */
-		bytes_in_out_buffer--;
-		
-		/* Output the character via the UART */
-		UDR0 = c;
+		UDR0 = tx_buffer[tail];
+		clear_transmit_complete();
+		tx_tail = (tail + 1) & TX_BUFFER_MASK;
 	} else {
 		/* No data in the buffer. We disable the UART Data
 		 * Register Empty interrupt because otherwise it 
@@ -253,10 +388,35 @@ ISR(USART0_UDRE_vect)
 	}
 }
 
+void serial_input_tick(void) {
+	if(escape_timeout && --escape_timeout == 0) {
+		if(escape_sequence_state == SEQ_ESCAPE) {
+			/* Nothing followed the ESC - it was the Escape key */
+			add_input_event(INPUT_KEY, ESCAPE_CHAR);
+		}
+		/* Otherwise the sequence wasn't finished - forget it */
+		escape_sequence_state = SEQ_NONE;
+	}
+}
+
+/* Return the class of a received character (see escape_sequence_table) */
+static uint8_t char_class(char c) {
+	if(c == ESCAPE_CHAR) {
+		return CHAR_ESCAPE;
+	} else if(c == '[' || c == 'O') {
+		return CHAR_INTRODUCER;
+	} else if(c >= 'A' && c <= 'D') {
+		return CHAR_ARROW;
+	} else if((c >= '0' && c <= '9') || c == ';') {
+		return CHAR_PARAMETER;
+	}
+	return CHAR_OTHER;
+}
+
 /*
  * Define the interrupt handler for UART Receive Complete (i.e. 
- * we can read a character. The character is read and placed in
- * the input buffer.
+ * we can read a character. The character is read, decoded and
+ * the resulting input events (if any) added to the event queue.
  */
 
 ISR(USART0_RX_vect) 
@@ -265,39 +425,35 @@ ISR(USART0_RX_vect)
 	char c;
 	c = UDR0;
 		
-	if(do_echo && bytes_in_out_buffer < OUTPUT_BUFFER_SIZE) {
-		/* If echoing is enabled and there is output buffer
-		 * space, echo the received character back to the UART.
-		 * (If there is no output buffer space, characters
-		 * will be lost.)
+	if(do_echo && tx_tail == tx_head && (UCSR0A & (1<<UDRE0))) {
+		/* If echoing is enabled and the UART isn't busy with other 
+		 * output, echo the received character straight back. (Only the
+		 * main program adds to the output buffer so we can't use it 
+		 * here - characters that arrive while output is in progress
+		 * are not echoed.)
 		 */
-		uart_put_char(c, 0);
+		UDR0 = c;
+		clear_transmit_complete();
 	}
 	
-	/* 
-	 * Check if we have space in our buffer. If not, set the overrun
-	 * flag and throw away the character. (We never clear the 
-	 * overrun flag - it's up to the programmer to check/clear
-	 * this flag if desired.)
-	 */
-	if(bytes_in_input_buffer >= INPUT_BUFFER_SIZE) {
-		input_overrun = 1;
-	} else {
-		/* If the character is a carriage return, turn it into a
-		 * linefeed 
-		*/
-		if (c == '\r') {
-			c = '\n';
-		}
-		
-		/* 
-		 * There is room in the input buffer 
-		 */
-		input_buffer[input_insert_pos++] = c;
-		bytes_in_input_buffer++;
-		if(input_insert_pos == INPUT_BUFFER_SIZE) {
-			/* Wrap around buffer pointer if necessary */
-			input_insert_pos = 0;
-		}
+	/* If the character is a carriage return, turn it into a
+	 * linefeed 
+	*/
+	if (c == '\r') {
+		c = '\n';
+	}
+	
+	uint8_t action = pgm_read_byte(
+			&escape_sequence_table[escape_sequence_state][char_class(c)]);
+	escape_sequence_state = action & 0x0F;
+	escape_timeout = (escape_sequence_state != SEQ_NONE) ? ESCAPE_TIMEOUT : 0;
+	if(action & EMIT_ESCAPE) {
+		add_input_event(INPUT_KEY, ESCAPE_CHAR);
+	}
+	if(action & EMIT_KEY) {
+		add_input_event(INPUT_KEY, c);
+	}
+	if(action & EMIT_ARROW) {
+		add_input_event(INPUT_ARROW, c);
 	}
 }
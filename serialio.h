@@ -8,8 +8,11 @@
  * any standard IO methods (e.g. printf). We use interrupt-based serial
  * IO and a circular buffer to store output messages. (This allows us 
  * to print many characters at once to the buffer and have them 
- * output by the UART as speed permits.) Interrupts must be enabled 
- * globally for this module to work (after init_serial_stdio() is called).
+ * output by the UART as speed permits.) Input is added to the input
+ * event queue as it arrives (see input_events.h) - ordinary characters
+ * as INPUT_KEY events and cursor keys (whose escape sequences are 
+ * decoded) as INPUT_ARROW events. Interrupts must be enabled globally for
+ * this module to work (after init_serial_stdio() is called).
  *
  */
 
@@ -18,6 +21,13 @@
 
 #include <stdint.h>
 
+/* Size of the output buffer (bytes). Must be a power of 2. (One byte less
+ * than this can be waiting to be sent.)
+ */
+#ifndef SERIAL_TX_BUFFER_SIZE
+#define SERIAL_TX_BUFFER_SIZE 256
+#endif
+
 /* Initialise serial IO using the UART. baudrate specifies the desired
  * baud rate (e.g. 19200) and echo determines whether incoming characters
  * are echoed back to the UART output as they are received (zero means no
@@ -25,15 +35,46 @@
  */
 void init_serial_stdio(long baudrate, int8_t echo);
 
-/* Test if input is available from the serial port. Return 0 if not,
- * non-zero otherwise. If there is input available then it can be read
- * with a suitable standard IO library function, e.g. fgetc().
+/* Wait until everything in the output buffer has been sent (returns 
+ * straight away if interrupts are disabled and there is anything left).
+ */
+void serial_flush(void);
+
+/* Change the baud rate (e.g. to 38400, 57600, 76800 or 115200) once
+ * everything already output has been sent. Double speed mode is used if
+ * it gets closer to the rate. serial_get_baud() returns the rate asked
+ * for and serial_baud_error() how far the actual rate is from it, in 
+ * tenths of a percent (e.g. 21 is 2.1% fast).
+ */
+void serial_set_baud(uint32_t baudrate);
+uint32_t serial_get_baud(void);
+int16_t serial_baud_error(void);
+
+/* Add length bytes to the output buffer, as they are (a \n is not 
+ * turned into \r\n as it is by the stdio functions). Much quicker than
+ * printing them one at a time. Like the stdio functions this waits for 
+ * space in the buffer if interrupts are enabled, and otherwise discards
+ * what doesn't fit. Must not be called from an interrupt handler.
+ */
+void serial_write(const char* data, uint16_t length);
+
+/* Return the number of bytes that can be output without waiting for room
+ * in the output buffer. Used to avoid blocking when the serial link can't
+ * keep up.
+ */
+uint16_t serial_tx_space(void);
+
+/* Return the number of bytes that have been output (wraps around when it
+ * overflows). Take the difference of two values to measure the output 
+ * between them.
  */
-int8_t serial_input_available(void);
+uint32_t serial_output_byte_count(void);
 
-/* Discard any input waiting to be read from the serial port. (Characters may
- * have been typed when we didn't want them - clear them.
+/* Called by the timer0 interrupt handler every millisecond. Reports an
+ * ESC received on its own (the Escape key) once it is clear that it isn't
+ * the start of an escape sequence, and drops an escape sequence that 
+ * hasn't been finished.
  */
-void clear_serial_input_buffer(void);
+void serial_input_tick(void);
 
 #endif /* SERIALIO_H_ */
\ No newline at end of file
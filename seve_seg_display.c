@@ -14,14 +14,29 @@
 #include "game.h"
 #include "terminalio.h"
 
-volatile uint32_t current_time;
-uint8_t seven_seg[10] = {63,6,91,79,102,109,125,7,127,111};
-uint32_t power_pellet_eaten_time = 0;
+// Segment patterns for the digits 0 to 9
+static const uint8_t seven_seg[10] PROGMEM = {63,6,91,79,102,109,125,7,127,111};
 uint8_t ssg_cc = 0;
 uint8_t next_phase = 0;
 uint32_t ssg_count = 0;
 uint8_t game_pause = 0;
 
+// What the interrupt handler shows - the segment patterns for the right
+// (0) and left (1) digits and how many of them are shown. These are only
+// changed by update_ssg() (which the main loop calls) so the handler has 
+// nothing to work out.
+static volatile uint8_t ssg_segments[2];
+static volatile uint8_t ssg_num_digits = 1;
+
+// The power pellet time the count shown is for (0 if none is shown) and 
+// the time the count next changes
+static uint32_t shown_power_pellet_time;
+static uint32_t next_update_time;
+
+// Longest time spent in the interrupt handler, in timer 0 counts (64 
+// cycles - see timer0.c)
+static volatile uint8_t isr_counts_max;
+
 void init_ssg(void) {
 	DDRC = 0xFF;
 	DDRD = (1 << DDRD2);
@@ -49,58 +64,91 @@ void unpause_ssg(void) {
 	game_pause = 0;
 }
 
-void display_number(uint8_t number, uint8_t digit) {
-	if (digit == 0) {
-		PORTD &= ~(1UL << 2);
-	} else {
-		PORTD |= 1 << 2;
+// Publish the segment patterns for the handler. Interrupts are turned off
+// so that the handler never sees half of an update.
+static void set_ssg_segments(uint8_t right, uint8_t left, uint8_t num_digits) {
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	ssg_segments[0] = right;
+	ssg_segments[1] = left;
+	ssg_num_digits = num_digits;
+	if (interrupts_were_enabled) {
+		sei();
+	}
+}
+
+uint8_t ssg_update_due(uint32_t current_time) {
+	if (game_pause) {
+		// The count is frozen while the game is paused
+		return 0;
+	}
+	if (get_power_pellet_eaten()) {
+		return shown_power_pellet_time != get_power_pellet_time() 
+				|| current_time >= next_update_time;
+	}
+	return shown_power_pellet_time != 0;
+}
+
+void update_ssg(uint32_t current_time) {
+	if (!ssg_update_due(current_time)) {
+		return;
+	}
+	if (!get_power_pellet_eaten()) {
+		// Power pellet has run out - display off
+		shown_power_pellet_time = 0;
+		set_ssg_segments(0, 0, 1);
+		return;
 	}
 	
-	PORTC = seven_seg[number];
+	// Calculate the number of seconds left
+	// Its then incremented by 1 to round up (E.g 14.8 (mod10) = 4 but needs to be 5).
+	shown_power_pellet_time = get_power_pellet_time();
+	uint32_t end_time = shown_power_pellet_time + 15000;
+	uint16_t time_left = current_time < end_time ? end_time - current_time : 0;
+	uint8_t whole_seconds = time_left / 1000;
+	uint8_t seconds = whole_seconds + 1;
+	next_update_time = end_time - whole_seconds * 1000UL + 1;
+	
+	// If time left is less than 10 seconds do not display the left hand side of ssg
+	if (seconds < 10) {
+		set_ssg_segments(pgm_read_byte(&seven_seg[seconds]), 0, 1);
+	} else {
+		set_ssg_segments(pgm_read_byte(&seven_seg[seconds % 10]), 
+				pgm_read_byte(&seven_seg[(seconds / 10) % 10]), 2);
+	}
 }
 
-void display_off(void) {
-	PORTC = 0;
+uint16_t get_ssg_isr_cycles_max(void) {
+	return isr_counts_max * 64;
+}
+
+void reset_ssg_isr_cycles_max(void) {
+	isr_counts_max = 0;
 }
 
 ISR(TIMER2_COMPA_vect) {
+	uint8_t start_count = TCNT0;
 	
-	if (get_power_pellet_eaten()) {
-		// Get current time and set the last time that the power pellet was eaten
-		
-		if (game_pause) {
-			current_time = get_paused_time();
-		} else {
-			current_time = get_current_time();
-		}
-		power_pellet_eaten_time = get_power_pellet_time();
-		
-		uint8_t value = 0;
-		// Calculate the number of seconds left
-		// Its then incremented by 1 to round up (E.g 14.8 (mod10) = 4 but needs to be 5).
-		uint8_t time = (power_pellet_eaten_time + 15000 - current_time) / 1000;
-		time++;
-		
-		if (ssg_cc == 0) {
-			value = time % 10;
-		} else if (time < 1) {
-			value = 0;
-		} else {
-			value = (time/10) % 10;
-		}
-		
-		// Display the number on ssg
-		display_number(value, ssg_cc);
-		
-		// Swap the display CC to display other side
+	// Select the digit and show its segments
+	if (ssg_cc == 0) {
+		PORTD &= ~(1 << 2);
+	} else {
+		PORTD |= 1 << 2;
+	}
+	PORTC = ssg_segments[ssg_cc];
+	
+	// Swap the display CC to display other side (if it is being shown)
+	if (ssg_num_digits == 2) {
 		ssg_cc = 1 - ssg_cc;
-		
-		// If time left is less than 10 seconds do not display the left hand side of ssg
-		if (time < 10) {
-			ssg_cc = 0;
-		}
 	} else {
-		display_off();
+		ssg_cc = 0;
+	}
+	
+	// Timer 0 counts to OCR0A and starts again
+	uint8_t end_count = TCNT0;
+	uint8_t counts = end_count >= start_count ? end_count - start_count 
+			: end_count + OCR0A + 1 - start_count;
+	if (counts > isr_counts_max) {
+		isr_counts_max = counts;
 	}
 }
-
@@ -9,8 +9,22 @@
 #ifndef SEVE_SEG_DISPLAY_H_
 #define SEVE_SEG_DISPLAY_H_
 
+#include <stdint.h>
+
 void init_ssg(void);
 void pause_ssg(void);
 void unpause_ssg(void);
 
+// The display shows the seconds of power pellet time left. The interrupt
+// handler that multiplexes the digits only shows segment patterns worked 
+// out by update_ssg(), which the main loop calls with the current time - 
+// it only does anything when ssg_update_due() (when the power pellet is 
+// eaten or runs out, and once a second in between).
+uint8_t ssg_update_due(uint32_t current_time);
+void update_ssg(uint32_t current_time);
+// Longest time (CPU cycles, to a resolution of 64) spent in the interrupt
+// handler since the last reset
+uint16_t get_ssg_isr_cycles_max(void);
+void reset_ssg_isr_cycles_max(void);
+
 #endif /* SEVE_SEG_DISPLAY_H_ */
\ No newline at end of file
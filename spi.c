@@ -5,8 +5,35 @@
  */ 
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include "spi.h"
 
+// Transmit queue. Bytes are added at spi_queue_head by spi_send_bytes() 
+// and removed from spi_queue_tail by the SPI transfer complete interrupt
+// handler, which starts the next transfer. The queue size must be a power 
+// of 2 (no larger than 128) so that the positions can wrap with a mask.
+// spi_busy is 1 while a transfer is in progress.
+#define SPI_QUEUE_MASK (SPI_QUEUE_SIZE - 1)
+static volatile uint8_t spi_queue[SPI_QUEUE_SIZE];
+static volatile uint8_t spi_queue_head;
+static volatile uint8_t spi_queue_tail;
+static volatile uint8_t spi_busy;
+
+// Largest number of bytes that have been waiting in the queue
+static uint8_t spi_queue_high_water;
+
+// Start the transfer of the next byte in the queue (if any). Called from
+// the interrupt handler, or with interrupts off.
+static void spi_start_next_byte(void) {
+	if(spi_queue_tail != spi_queue_head) {
+		spi_busy = 1;
+		SPDR0 = spi_queue[spi_queue_tail];
+		spi_queue_tail = (spi_queue_tail + 1) & SPI_QUEUE_MASK;
+	} else {
+		spi_busy = 0;
+	}
+}
+
 void spi_setup_master(uint8_t clockdivider) {
 	// Set up SPI communication as a master
 	// Make the SS, MOSI and SCK pins outputs. These are pins
@@ -20,7 +47,8 @@ void spi_setup_master(uint8_t clockdivider) {
 	// Set up the SPI control registers SPCR and SPSR:
 	// - SPE bit = 1 (SPI is enabled)
 	// - MSTR bit = 1 (Master Mode)
-	SPCR0 = (1<<SPE0)|(1<<MSTR0);
+	// - SPIE bit = 1 (transfer complete interrupt enabled)
+	SPCR0 = (1<<SPE0)|(1<<MSTR0)|(1<<SPIE0);
 	
 	// Set SPR0 and SPR1 bits in SPCR and SPI2X bit in SPSR
 	// based on the given clock divider
@@ -52,18 +80,72 @@ void spi_setup_master(uint8_t clockdivider) {
 	
 	// Take SS (slave select) line low
 	PORTB &= ~(1<<4);
+	
+	// Empty the transmit queue
+	spi_queue_head = 0;
+	spi_queue_tail = 0;
+	spi_busy = 0;
 }
 
-uint8_t spi_send_byte(uint8_t byte) {
-	// Write out the byte to the SPDR0 register. This will initiate
-	// the transfer. We then wait until the most significant byte of
-	// SPSR0 (SPIF0 bit) is set - this indicates that the transfer is
-	// complete. (The final read of SPSR0 followed by a read of SPDR0
-	// will cause the SPIF bit to be reset to 0. See page 173 of the 
-	// ATmega324A datasheet.)
-	SPDR0 = byte;
-	while((SPSR0 & (1<<SPIF0)) == 0) {
-		; // wait
+void spi_send_bytes(const uint8_t* bytes, uint8_t num_bytes) {
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	
+	for(uint8_t i = 0; i < num_bytes; i++) {
+		uint8_t next_head = (spi_queue_head + 1) & SPI_QUEUE_MASK;
+		while(next_head == spi_queue_tail) {
+			// Queue is full - wait for the interrupt handler to take
+			// a byte. If interrupts are off we have to do its job.
+			if(!interrupts_were_enabled && (SPSR0 & (1<<SPIF0))) {
+				(void)SPDR0;
+				spi_start_next_byte();
+			}
+		}
+		spi_queue[spi_queue_head] = bytes[i];
+		spi_queue_head = next_head;
+		
+		uint8_t queued = (spi_queue_head - spi_queue_tail) & SPI_QUEUE_MASK;
+		if(queued > spi_queue_high_water) {
+			spi_queue_high_water = queued;
+		}
+		
+		// If no transfer is in progress, start one. (Interrupts are off
+		// briefly so the handler can't finish a transfer between the 
+		// test and the start.)
+		if(!spi_busy) {
+			cli();
+			if(!spi_busy) {
+				spi_start_next_byte();
+			}
+			if(interrupts_were_enabled) {
+				sei();
+			}
+		}
 	}
+}
+
+void spi_flush(void) {
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	while(spi_busy) {
+		if(!interrupts_were_enabled && (SPSR0 & (1<<SPIF0))) {
+			(void)SPDR0;
+			spi_start_next_byte();
+		}
+	}
+}
+
+uint8_t spi_queue_high_water_mark(void) {
+	return spi_queue_high_water;
+}
+
+uint8_t spi_send_byte(uint8_t byte) {
+	// Queue the byte and wait until it (and anything queued before it)
+	// has been sent. The last byte received is then in SPDR0.
+	spi_send_bytes(&byte, 1);
+	spi_flush();
 	return SPDR0;
-}
\ No newline at end of file
+}
+
+// Interrupt handler for SPI transfer complete - start the next transfer
+ISR(SPI_STC_vect) {
+	spi_start_next_byte();
+}
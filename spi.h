@@ -7,12 +7,32 @@
 #ifndef SPI_H_
 #define SPI_H_
 
+#include <stdint.h>
+
+// Size of the transmit queue (bytes). Must be a power of 2, no larger
+// than 128. spi_queue_high_water_mark() can be used to size it.
+#ifndef SPI_QUEUE_SIZE
+#define SPI_QUEUE_SIZE 64
+#endif
+
 // Set up SPI communication as a master.
 // clockdivider should be one of 2,4,8,16,32,64,128
 void spi_setup_master(uint8_t clockdivider);
 
-// Send and receive an SPI byte. This function will take at least 8 
-// cyles of the divided clock (i.e. will busy wait).
+// Queue bytes to be sent. Transfers are driven by the SPI transfer 
+// complete interrupt so this returns as soon as the bytes are queued
+// (only waiting if the queue is full). Any bytes received are discarded.
+void spi_send_bytes(const uint8_t* bytes, uint8_t num_bytes);
+
+// Wait until all queued bytes have been sent
+void spi_flush(void);
+
+// Return the largest number of bytes that have been waiting in the queue
+uint8_t spi_queue_high_water_mark(void);
+
+// Send and receive an SPI byte. This function will wait until the byte
+// has been sent (i.e. will busy wait for at least 8 cycles of the divided
+// clock plus the time to send anything already queued).
 uint8_t spi_send_byte(uint8_t byte);
 
 #endif /* SPI_H_ */
\ No newline at end of file
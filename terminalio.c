@@ -6,13 +6,114 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <avr/pgmspace.h>
 
 #include "terminalio.h"
+#include "serialio.h"
+
+/* Terminal state as we last set it, so that we can avoid sending escape
+ * sequences that wouldn't change anything.
+ * The cursor position (cursor_x, cursor_y) is only known to be right if
+ * nothing has been output since we last updated it - i.e. the serial
+ * output byte count is still output_count_at_cursor. Anything printed 
+ * other than through put_glyph() makes the position unknown.
+ * The display attributes are tracked as the current foreground and
+ * background colours (0 if the default) and a bit mask of the other 
+ * attributes (bit n set for attribute n). attributes_known is 0 until
+ * the attributes have been reset for the first time.
+ */
+static int cursor_x;
+static int cursor_y;
+static uint32_t output_count_at_cursor;
+static uint8_t current_foreground;
+static uint8_t current_background;
+static uint16_t current_attributes;
+static uint8_t attributes_known;
+
+static uint8_t cursor_position_known(void) {
+	return cursor_x != 0 && serial_output_byte_count() == output_count_at_cursor;
+}
+
+static void set_cursor_position(int x, int y) {
+	cursor_x = x;
+	cursor_y = y;
+	output_count_at_cursor = serial_output_byte_count();
+}
+
+/* Number of characters needed to print the given (non-negative) number */
+static uint8_t num_digits(int value) {
+	uint8_t digits = 1;
+	while(value >= 10) {
+		value /= 10;
+		digits++;
+	}
+	return digits;
+}
+
+/* The escape sequences sent most often (cursor moves, attribute changes
+ * and glyphs) are built here and added to the output buffer in one go 
+ * with serial_write() rather than formatted by printf_P() and output one
+ * character at a time. Sequences start with ESC [ (the control sequence 
+ * introducer) and are no longer than this.
+ */
+#define MAX_SEQUENCE_LENGTH 16
+
+/* Write the given (non-negative) number in decimal at p and return a 
+ * pointer to just after it
+ */
+static char* append_number(char* p, int value) {
+	char* end = p + num_digits(value);
+	p = end;
+	do {
+		*--p = '0' + value % 10;
+		value /= 10;
+	} while(value);
+	return end;
+}
 
 void move_cursor(int x, int y) {
-    printf_P(PSTR("\x1b[%d;%dH"), y, x);
+	char sequence[MAX_SEQUENCE_LENGTH];
+	char* p = sequence;
+	*p++ = '\x1b';
+	*p++ = '[';
+	if(cursor_position_known() && y == cursor_y) {
+		if(x == cursor_x) {
+			/* Already there */
+			return;
+		}
+		/* Same row - use a relative move (ESC [ n C or ESC [ n D) if it is
+		 * shorter than an absolute one (ESC [ y ; x H). The count is left
+		 * out when it is 1.
+		 */
+		int distance = (x > cursor_x) ? x - cursor_x : cursor_x - x;
+		uint8_t relative_length = 3 + (distance == 1 ? 0 : num_digits(distance));
+		uint8_t absolute_length = 4 + num_digits(x) + num_digits(y);
+		if(relative_length < absolute_length) {
+			if(distance != 1) {
+				p = append_number(p, distance);
+			}
+			*p++ = (x > cursor_x) ? 'C' : 'D';
+			serial_write(sequence, p - sequence);
+			set_cursor_position(x, y);
+			return;
+		}
+	}
+	p = append_number(p, y);
+	*p++ = ';';
+	p = append_number(p, x);
+	*p++ = 'H';
+	serial_write(sequence, p - sequence);
+	set_cursor_position(x, y);
+}
+
+void put_glyph(const char* glyph) {
+	uint8_t known = cursor_position_known();
+	serial_write(glyph, strlen(glyph));
+	if(known) {
+		set_cursor_position(cursor_x + 1, cursor_y);
+	}
 }
 
 void move_cursor_up(void) {
@@ -31,12 +132,34 @@ void move_cursor_right(void) {
 	printf_P(PSTR("\x1b[1C"));
 }
 
+/* Attribute changes don't move the cursor, so we keep it known */
+static void output_attribute(uint8_t parameter) {
+	uint8_t known = cursor_position_known();
+	char sequence[MAX_SEQUENCE_LENGTH];
+	sequence[0] = '\x1b';
+	sequence[1] = '[';
+	char* p = append_number(sequence + 2, parameter);
+	*p++ = 'm';
+	serial_write(sequence, p - sequence);
+	if(known) {
+		set_cursor_position(cursor_x, cursor_y);
+	}
+}
+
 void normal_display_mode(void) {
-	printf_P(PSTR("\x1b[0m"));
+	if(attributes_known && current_foreground == 0 && current_background == 0
+			&& current_attributes == 0) {
+		return;
+	}
+	output_attribute(TERM_RESET);
+	current_foreground = 0;
+	current_background = 0;
+	current_attributes = 0;
+	attributes_known = 1;
 }
 
 void reverse_video(void) {
-	printf_P(PSTR("\x1b[7m"));
+	set_display_attribute(TERM_REVERSE);
 }
 
 void clear_terminal(void) {
@@ -48,7 +171,47 @@ void clear_to_end_of_line(void) {
 }
 
 void set_display_attribute(DisplayParameter parameter) {
-	printf_P(PSTR("\x1b[%dm"), parameter);
+	if(parameter == TERM_RESET) {
+		normal_display_mode();
+		return;
+	}
+	if(attributes_known) {
+		if(parameter >= FG_BLACK && parameter <= FG_WHITE) {
+			if(current_foreground == parameter) {
+				return;
+			}
+			current_foreground = parameter;
+		} else if(parameter >= BG_BLACK && parameter <= BG_WHITE) {
+			if(current_background == parameter) {
+				return;
+			}
+			current_background = parameter;
+		} else {
+			if(current_attributes & (1 << parameter)) {
+				return;
+			}
+			current_attributes |= (1 << parameter);
+		}
+	}
+	output_attribute(parameter);
+}
+
+/* Character set changes don't move the cursor either */
+static void select_character_set(char set) {
+	uint8_t known = cursor_position_known();
+	char sequence[3] = { '\x1b', '(', set };
+	serial_write(sequence, sizeof(sequence));
+	if(known) {
+		set_cursor_position(cursor_x, cursor_y);
+	}
+}
+
+void enter_line_drawing_mode(void) {
+	select_character_set('0');
+}
+
+void exit_line_drawing_mode(void) {
+	select_character_set('B');
 }
 
 void hide_cursor() {
@@ -80,10 +243,7 @@ void draw_horizontal_line(int8_t y, int8_t start_x, int8_t end_x) {
 	move_cursor(start_x, y);
 	reverse_video();
 	for(i=start_x; i <= end_x; i++) {
-		printf(" ");	/* No need to use printf_P - printing 
-						 * a single character gets optimised
-						 * to a putchar call 
-						 */
+		put_glyph(" ");
 	}
 	normal_display_mode();
 }
@@ -54,6 +54,12 @@ typedef enum {
 	BG_WHITE = 47
 } DisplayParameter;
 
+/* The cursor position and display attributes last set are remembered and
+ * sequences that wouldn't change anything are not sent. move_cursor() uses
+ * a relative move when it is shorter than an absolute one. Output other 
+ * than through put_glyph() makes the cursor position unknown (and the
+ * next move absolute).
+ */
 void move_cursor(int x, int y);
 void move_cursor_up(void);		// by one row
 void move_cursor_down(void);	// by one row
@@ -64,6 +70,17 @@ void reverse_video(void);
 void clear_terminal(void);
 void clear_to_end_of_line(void);
 void set_display_attribute(DisplayParameter parameter);
+
+// Output a character (or UTF-8 sequence) that occupies one column at the
+// cursor position, keeping track of where the cursor ends up.
+void put_glyph(const char* glyph);
+
+// Switch the terminal to/from the DEC Special Graphics character set
+// (ESC ( 0 and ESC ( B). While it is selected, lower case letters (and a
+// few other characters) are shown as line drawing characters.
+void enter_line_drawing_mode(void);
+void exit_line_drawing_mode(void);
+
 void hide_cursor(void);
 void show_cursor(void);
 
@@ -12,6 +12,8 @@
 #include <avr/interrupt.h>
 
 #include "timer0.h"
+#include "serialio.h"
+#include "buzzer.h"
 
 /* Our internal clock tick count - incremented every 
  * millisecond. Will overflow every ~49 days. */
@@ -74,6 +76,29 @@ uint32_t get_current_time(void) {
 	return returnValue;
 }
 
+uint32_t get_current_cycles(void) {
+	uint32_t ticks;
+	uint8_t count;
+
+	/* Read the tick count and the timer value together. If the compare
+	 * match has happened but the interrupt hasn't been serviced yet
+	 * (the flag is still set and the counter has restarted) then the
+	 * tick count is one behind.
+	 */
+	uint8_t interruptsOn = bit_is_set(SREG, SREG_I);
+	cli();
+	ticks = clockTicks;
+	count = TCNT0;
+	if((TIFR0 & (1<<OCF0A)) && count < OCR0A) {
+		ticks++;
+	}
+	if(interruptsOn) {
+		sei();
+	}
+	/* 8000 clock cycles per tick, 64 clock cycles per timer count */
+	return ticks * 8000UL + (uint16_t)count * 64;
+}
+
 void pause_time(void) {
 	temp_time = clockTicks;
 }
@@ -97,4 +122,10 @@ void set_time(uint32_t value) {
 ISR(TIMER0_COMPA_vect) {
 	/* Increment our clock tick count */
 	clockTicks++;
+	
+	/* Time out a lone ESC received by the serial port */
+	serial_input_tick();
+	
+	/* Move the buzzer on to its next note when the current one ends */
+	buzzer_tick();
 }
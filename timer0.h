@@ -29,6 +29,13 @@ void init_timer0(void);
  * initialised.
  */
 uint32_t get_current_time(void);
+
+/* Return the number of CPU clock cycles since the timer was initialised,
+ * to a resolution of 64 cycles (one timer count). Wraps roughly every
+ * 9 minutes so is only useful for measuring short intervals (take the
+ * difference of two readings).
+ */
+uint32_t get_current_cycles(void);
 uint32_t get_paused_time(void);
 void unpause_time(void);
 void pause_time(void);